@@ -0,0 +1,941 @@
+// //////////////////////////////////////////////////////////
+// benchmark.c
+// Copyright (c) 2014,2019 Stephan Brumme. All rights reserved.
+// see http://create.stephan-brumme.com/disclaimer.html
+//
+
+// gcc -O3 -std=c99 -Wall -pedantic search.c searchjit.c benchmark.c -o benchmark -lm
+// measures throughput of all search algorithms, can store results as a baseline and compare later runs against it
+// whole file is loaded into RAM (same as mygrep)
+
+// enable GNU extensions, such as memmem(), clock_gettime() and sched_setaffinity()
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include "search.h"
+#include "searchjit.h"
+
+#include <string.h> // memmem()
+#include <stdio.h>  // printf()
+#include <stdlib.h> // malloc(), qsort()
+#include <math.h>   // sqrt()
+#include <time.h>   // clock_gettime()
+#include <sched.h>  // sched_setaffinity()
+#include <stdint.h> // uint64_t
+
+
+/// GNU memmem() is declared with void pointers
+static const char* searchMemMem(const char* haystack, size_t haystackLength,
+                                const char* needle,   size_t needleLength)
+{
+  return (const char*)memmem(haystack, haystackLength, needle, needleLength);
+}
+
+/// byte frequencies of the current haystack, see searchNativeRareByteTrained()
+static unsigned char trainedFrequency[256];
+
+/// rarest byte according to the haystack's byte frequencies
+static const char* searchNativeRareByteTrained(const char* haystack, size_t haystackLength,
+                                               const char* needle,   size_t needleLength)
+{
+  return searchNativeRareByteTable(haystack, haystackLength, needle, needleLength, trainedFrequency);
+}
+
+/// every algorithm that will be benchmarked
+static const struct
+{
+  const char*    name;
+  SearchFunction function;
+} algorithms[] =
+{
+  { "memmem",             searchMemMem                       },
+  { "simple",             searchSimple                       },
+  { "native",             searchNative                       },
+  { "swar",               searchSWAR                         },
+  { "sse42",              searchSSE42                        },
+  { "avx512",             searchAVX512                       },
+  { "avx2",               searchAVX2                         },
+  { "rarebyte",           searchNativeRareByte               },
+  { "rarebytetrained",    searchNativeRareByteTrained        },
+  { "knuthmorrispratt",   searchKnuthMorrisPratt             },
+  { "boyermoorehorspool", searchBoyerMooreHorspool           },
+  { "quicksearch",        searchQuickSearch                  },
+  { "raita",              searchRaita                        },
+  { "hash3",              searchHash3                        },
+  { "hash5",              searchHash5                        },
+  { "hash8",              searchHash8                        },
+  { "boyermoore",         searchBoyerMoore                   },
+  { "bndm",               searchBackwardNondeterministicDawg },
+  { "bom",                searchBackwardOracleMatching       },
+  { "bitap",              searchBitap                        },
+  { "rabinkarp",          searchRabinKarp                    },
+  { "rabinkarp64",        searchRabinKarp64                  },
+  // ignore ASCII case (may find more matches)
+  { "swarnocase",         searchSWARNoCase                   },
+  { "avx2nocase",         searchAVX2NoCase                   },
+  { "bmhnocase",          searchBoyerMooreHorspoolNoCase     },
+  { "bitapnocase",        searchBitapNoCase                  }
+};
+static const size_t NumAlgorithms = sizeof(algorithms) / sizeof(algorithms[0]);
+
+
+/// result of repeated runs of a single algorithm/needle pair (all values in nanoseconds)
+typedef struct
+{
+  double median;
+  /// 95% confidence interval of the median
+  double low;
+  double high;
+} Measurement;
+
+/// one line of a baseline file
+typedef struct
+{
+  char        name[64];
+  char        needle[2 * 256 + 1]; // hex-encoded
+  Measurement measurement;
+} BaselineEntry;
+
+
+/// current time in nanoseconds
+static double now()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/// for qsort()
+static int compareDouble(const void* a, const void* b)
+{
+  double x = *(const double*)a;
+  double y = *(const double*)b;
+  return (x > y) - (x < y);
+}
+
+/// count all matches, the compiler can't optimize it away because the result is used
+static unsigned int countMatches(SearchFunction function,
+                                 const char* haystack, size_t haystackLength,
+                                 const char* needle,   size_t needleLength)
+{
+  unsigned int numHits = 0;
+  const char* haystackEnd = haystack + haystackLength;
+  const char* current     = haystack;
+  while ((current = function(current, haystackEnd - current, needle, needleLength)) != NULL)
+  {
+    numHits++;
+    // overlapping matches are allowed
+    if (++current == haystackEnd)
+      break;
+  }
+  return numHits;
+}
+
+/// run a single algorithm/needle pair several times, return median and its confidence interval
+static Measurement measure(SearchFunction function, unsigned int numRuns,
+                           const char* haystack, size_t haystackLength,
+                           const char* needle,   size_t needleLength,
+                           unsigned int* numHits)
+{
+  double* durations = (double*)malloc(numRuns * sizeof(double));
+
+  // warm up caches
+  *numHits = countMatches(function, haystack, haystackLength, needle, needleLength);
+
+  unsigned int run;
+  for (run = 0; run < numRuns; run++)
+  {
+    double start = now();
+    *numHits = countMatches(function, haystack, haystackLength, needle, needleLength);
+    durations[run] = now() - start;
+  }
+
+  // median
+  qsort(durations, numRuns, sizeof(double), compareDouble);
+  Measurement result;
+  result.median = (numRuns & 1) ? durations[numRuns / 2] :
+                                  (durations[numRuns / 2 - 1] + durations[numRuns / 2]) / 2;
+
+  // distribution-free confidence interval of the median, based on order statistics:
+  // ranks n/2 -+ 1.96 * sqrt(n) / 2 (95% confidence)
+  double spread = 0.98 * sqrt(numRuns);
+  int lowRank   = (int)(numRuns / 2.0 - spread);
+  int highRank  = (int)(numRuns / 2.0 + spread + 0.999);
+  if (lowRank  < 0)
+    lowRank  = 0;
+  if (highRank > (int)numRuns - 1)
+    highRank = numRuns - 1;
+  result.low  = durations[lowRank];
+  result.high = durations[highRank];
+
+  free(durations);
+  return result;
+}
+
+
+/// per-call latency of an algorithm on many small haystacks, writes p50 and p99 (in nanoseconds)
+static void measureLatency(SearchFunction function, size_t numSamples,
+                           const char* data,   size_t dataLength, size_t haystackLength,
+                           const char* needle, size_t needleLength,
+                           double* p50, double* p99)
+{
+  // each sample is a batch of a few calls, else the timer's overhead would dominate
+  const size_t BatchSize = 8;
+  double* durations = (double*)malloc(numSamples * sizeof(double));
+
+  // pick haystacks from all over the file
+  size_t stride = 4099;
+  size_t offset = 0;
+  size_t sample;
+  volatile size_t sink = 0;
+  for (sample = 0; sample < numSamples; sample++)
+  {
+    const char* haystack = data + offset;
+    offset = (offset + stride) % (dataLength - haystackLength + 1);
+
+    double start = now();
+    size_t batch;
+    for (batch = 0; batch < BatchSize; batch++)
+      sink += (size_t)function(haystack, haystackLength, needle, needleLength);
+    durations[sample] = (now() - start) / BatchSize;
+  }
+
+  qsort(durations, numSamples, sizeof(double), compareDouble);
+  *p50 = durations[numSamples / 2];
+  *p99 = durations[(numSamples * 99) / 100];
+
+  free(durations);
+}
+
+/// benchmark tiny haystacks: separate preprocessing (haystack as long as needle) from scanning
+static void benchmarkLatency(const char* data,   size_t dataLength,
+                             const char* needle, size_t needleLength)
+{
+  const size_t HaystackLengths[] = { 32, 64, 128, 256 };
+  const size_t NumSamples        = 20000;
+
+  printf("%-20s %6s %8s %8s %8s %8s %8s\n", "algorithm", "bytes",
+         "p50 ns", "p99 ns", "prep p50", "prep p99", "scan p50");
+
+  size_t h;
+  for (h = 0; h < sizeof(HaystackLengths) / sizeof(HaystackLengths[0]); h++)
+  {
+    size_t haystackLength = HaystackLengths[h];
+    if (haystackLength > dataLength || haystackLength < needleLength)
+      continue;
+
+    size_t a;
+    for (a = 0; a < NumAlgorithms; a++)
+    {
+      // full call
+      double total50, total99;
+      measureLatency(algorithms[a].function, NumSamples, data, dataLength, haystackLength,
+                     needle, needleLength, &total50, &total99);
+      // just a single window => almost only preprocessing
+      double prep50, prep99;
+      measureLatency(algorithms[a].function, NumSamples, data, dataLength, needleLength,
+                     needle, needleLength, &prep50, &prep99);
+
+      double scan50 = total50 > prep50 ? total50 - prep50 : 0;
+      printf("%-20s %6d %8.1f %8.1f %8.1f %8.1f %8.1f\n", algorithms[a].name, (int)haystackLength,
+             total50, total99, prep50, prep99, scan50);
+    }
+  }
+}
+
+
+/// dependent chain of scalar integer operations, returns iterations per nanosecond (proportional to the core's clock rate)
+static double scalarSpeed(size_t iterations)
+{
+  uint64_t x = 1;
+  double start = now();
+  size_t i;
+  for (i = 0; i < iterations; i++)
+    x = x * 3 + (x >> 7);
+  double duration = now() - start;
+
+  // prevent the compiler from removing the loop
+  volatile uint64_t sink = x;
+  (void)sink;
+  return iterations / duration;
+}
+
+/// median of several short runs of scalarSpeed (each about 100 microseconds), robust against interrupts and timer jitter
+static double scalarSpeedMedian()
+{
+  enum { NumProbes = 9 };
+  const size_t ProbeIterations = 100000;
+  double speeds[NumProbes];
+  size_t i;
+  for (i = 0; i < NumProbes; i++)
+    speeds[i] = scalarSpeed(ProbeIterations);
+  qsort(speeds, NumProbes, sizeof(double), compareDouble);
+  return speeds[NumProbes / 2];
+}
+
+/// SIMD kernels may lower the CPU's clock rate (especially AVX-512), which slows down everything else, too:
+/// measure steady-state throughput of each kernel and the speed of scalar code right after it
+static void benchmarkDownclock(const char* haystack, size_t haystackLength,
+                               const char* needle,   size_t needleLength)
+{
+  static const struct
+  {
+    const char*    name;
+    SearchFunction function;
+  } kernels[] =
+  {
+    { "native", searchNative },
+    { "swar",   searchSWAR   },
+    { "avx2",   searchAVX2   },
+    { "avx512", searchAVX512 }
+  };
+  // long enough to reach steady state
+  const double Duration = 300e6;
+
+  printf("%-10s %10s %14s\n", "kernel", "MB/s", "scalar after");
+
+  size_t k;
+  for (k = 0; k < sizeof(kernels) / sizeof(kernels[0]); k++)
+  {
+    // reference speed of scalar code (after a pause of SIMD code, warm up first),
+    // exactly the same probes as afterwards
+    scalarSpeed(10000000);
+    double before = scalarSpeedMedian();
+
+    double start = now();
+    double bytes = 0;
+    while (now() - start < Duration)
+    {
+      countMatches(kernels[k].function, haystack, haystackLength, needle, needleLength);
+      bytes += haystackLength;
+    }
+    double elapsed = now() - start;
+
+    // about 1 millisecond, immediately after the SIMD code (before the CPU switches back to its normal clock rate)
+    double after = scalarSpeedMedian();
+
+    printf("%-10s %10.1f %+13.1f%%\n", kernels[k].name,
+           bytes / (elapsed / 1e9) / (1 << 20), 100 * (after / before - 1));
+  }
+}
+
+
+/// same as countMatches, for generated code
+static unsigned int countJitMatches(const JitSearch* jit, const char* haystack, size_t haystackLength)
+{
+  unsigned int numHits = 0;
+  const char* haystackEnd = haystack + haystackLength;
+  const char* current     = haystack;
+  while ((current = searchJit(jit, current, haystackEnd - current)) != NULL)
+  {
+    numHits++;
+    if (++current == haystackEnd)
+      break;
+  }
+  return numHits;
+}
+
+/// generated code must amortize its compilation: find the haystack size where it beats the generic kernels
+static void benchmarkJit(const char* data,   size_t dataLength,
+                         const char* needle, size_t needleLength)
+{
+  // average cost of code generation
+  const size_t NumCompiles = 2000;
+  double start = now();
+  size_t i;
+  for (i = 0; i < NumCompiles; i++)
+    freeJitSearch(compileJitSearch(needle, needleLength));
+  double compileTime = (now() - start) / NumCompiles;
+
+  JitSearch* jit = compileJitSearch(needle, needleLength);
+  if (!hasJitCode(jit))
+  {
+    printf("no code generated (unsupported CPU/OS or needle length)\n");
+    freeJitSearch(jit);
+    return;
+  }
+  printf("code generation %.1f ns\n", compileTime);
+  printf("%10s %12s %12s %12s %14s\n", "bytes", "native ns", "avx2 ns", "jit ns", "jit+compile ns");
+
+  // about 64 MB per haystack size, taken from all over the file
+  const size_t BytesPerSize = 64 << 20;
+  size_t breakEven = 0;
+  size_t haystackLength;
+  for (haystackLength = 64; haystackLength <= dataLength; haystackLength *= 4)
+  {
+    size_t numCalls = BytesPerSize / haystackLength;
+    double durations[3];
+    volatile unsigned int sink = 0;
+    int kernel;
+    for (kernel = 0; kernel < 3; kernel++)
+    {
+      size_t offset = 0;
+      start = now();
+      for (i = 0; i < numCalls; i++)
+      {
+        const char* haystack = data + offset;
+        offset = (offset + 4099) % (dataLength - haystackLength + 1);
+        if (kernel == 0)
+          sink += countMatches(searchNative, haystack, haystackLength, needle, needleLength);
+        else if (kernel == 1)
+          sink += countMatches(searchAVX2,   haystack, haystackLength, needle, needleLength);
+        else
+          sink += countJitMatches(jit, haystack, haystackLength);
+      }
+      durations[kernel] = (now() - start) / numCalls;
+    }
+
+    double best = durations[0] < durations[1] ? durations[0] : durations[1];
+    double withCompile = durations[2] + compileTime;
+    if (breakEven == 0 && withCompile < best)
+      breakEven = haystackLength;
+
+    printf("%10d %12.1f %12.1f %12.1f %14.1f\n", (int)haystackLength,
+           durations[0], durations[1], durations[2], withCompile);
+  }
+
+  if (breakEven > 0)
+    printf("break-even at about %d bytes (including code generation)\n", (int)breakEven);
+  else
+    printf("generated code never beats the generic kernels\n");
+
+  freeJitSearch(jit);
+}
+
+
+/// measure crossover points between algorithms on this machine and this kind of data, write a profile for selectSearchFunction
+static int calibrate(const char* haystack, size_t haystackLength, unsigned int numRuns, const char* filename)
+{
+  static const struct
+  {
+    const char*    name;
+    SearchFunction function;
+  } kernels[] =
+  {
+    { "native", searchNative },
+    { "swar",   searchSWAR   },
+    { "sse42",  searchSSE42  },
+    { "avx2",   searchAVX2   },
+    { "avx512", searchAVX512 }
+  };
+  const size_t NumKernels = sizeof(kernels) / sizeof(kernels[0]);
+
+  SearchProfile profile;
+  defaultSearchProfile(&profile);
+  unsigned int numHits;
+
+  // fastest kernel for short needles (taken from the middle of the file)
+  const size_t ShortLengths[]  = { 4, 8, 16 };
+  const size_t NumShortLengths = sizeof(ShortLengths) / sizeof(ShortLengths[0]);
+  SearchFunction kernel = searchNative;
+  double best = 0;
+  size_t k, n;
+  for (k = 0; k < NumKernels; k++)
+  {
+    double total = 0;
+    for (n = 0; n < NumShortLengths && ShortLengths[n] <= haystackLength; n++)
+    {
+      const char* needle = haystack + (haystackLength - ShortLengths[n]) / 2;
+      total += measure(kernels[k].function, numRuns, haystack, haystackLength, needle, ShortLengths[n], &numHits).median;
+    }
+    printf("kernel %-8s %10.3f ms\n", kernels[k].name, total / 1e6);
+
+    if (k == 0 || total < best)
+    {
+      best   = total;
+      kernel = kernels[k].function;
+      strcpy(profile.shortKernel, kernels[k].name);
+    }
+  }
+
+  // needle length where Boyer-Moore-Horspool overtakes that kernel
+  const size_t LongLengths[] = { 8, 16, 32, 64, 128, 256, 1024 };
+  size_t previous = 4;
+  profile.longNeedle = (size_t)-1;
+  for (n = 0; n < sizeof(LongLengths) / sizeof(LongLengths[0]) && LongLengths[n] <= haystackLength; n++)
+  {
+    const char* needle = haystack + (haystackLength - LongLengths[n]) / 2;
+    double timeKernel = measure(kernel,                   numRuns, haystack, haystackLength, needle, LongLengths[n], &numHits).median;
+    double timeBMH    = measure(searchBoyerMooreHorspool, numRuns, haystack, haystackLength, needle, LongLengths[n], &numHits).median;
+    printf("needle %4d bytes: %-8s %8.3f ms, boyermoorehorspool %8.3f ms\n",
+           (int)LongLengths[n], profile.shortKernel, timeKernel / 1e6, timeBMH / 1e6);
+
+    if (timeBMH < timeKernel)
+    {
+      profile.longNeedle = previous;
+      break;
+    }
+    previous = LongLengths[n];
+  }
+
+  // haystack size where searchNative's lack of setup costs stops to matter (per call, 8 byte needle for the kernel,
+  // a needle just long enough for Boyer-Moore-Horspool), searchNative must beat both
+  const size_t SmallLengths[] = { 16, 32, 64, 128, 256, 512, 1024 };
+  const size_t NumSamples     = 20000;
+  const size_t SmallNeedle    = 8;
+  int          useBMH         = profile.longNeedle != (size_t)-1;
+  size_t       LongNeedle     = useBMH ? profile.longNeedle + 1 : 0;
+  profile.smallHaystack = 0;
+  for (n = 0; n < sizeof(SmallLengths) / sizeof(SmallLengths[0]); n++)
+  {
+    if (SmallLengths[n] > haystackLength)
+      break;
+
+    double native50, native99, kernel50, kernel99;
+    if (kernel != searchNative)
+    {
+      const char* needle = haystack + (haystackLength - SmallNeedle) / 2;
+      measureLatency(searchNative, NumSamples, haystack, haystackLength, SmallLengths[n], needle, SmallNeedle, &native50, &native99);
+      measureLatency(kernel,       NumSamples, haystack, haystackLength, SmallLengths[n], needle, SmallNeedle, &kernel50, &kernel99);
+      printf("haystack %4d bytes: native %6.1f ns, %-8s %6.1f ns\n",
+             (int)SmallLengths[n], native50, profile.shortKernel, kernel50);
+      if (native50 > kernel50)
+        break;
+    }
+
+    if (useBMH && LongNeedle <= SmallLengths[n])
+    {
+      const char* needle = haystack + (haystackLength - LongNeedle) / 2;
+      measureLatency(searchNative,             NumSamples, haystack, haystackLength, SmallLengths[n], needle, LongNeedle, &native50, &native99);
+      measureLatency(searchBoyerMooreHorspool, NumSamples, haystack, haystackLength, SmallLengths[n], needle, LongNeedle, &kernel50, &kernel99);
+      printf("haystack %4d bytes: native %6.1f ns, boyermoorehorspool %6.1f ns (%d byte needle)\n",
+             (int)SmallLengths[n], native50, kernel50, (int)LongNeedle);
+      if (native50 > kernel50)
+        break;
+    }
+
+    profile.smallHaystack = SmallLengths[n];
+  }
+
+  // needles from all over the file: which rank of their rarest byte makes searchNativeRareByte faster than the kernel ?
+  const size_t NumSamplesRare = 48;
+  const size_t RareLength     = 16;
+  int    ranks     [NumSamplesRare];
+  double timeRare  [NumSamplesRare];
+  double timeKernel[NumSamplesRare];
+  size_t numRare = 0;
+  for (n = 0; n < NumSamplesRare && haystackLength >= NumSamplesRare * RareLength; n++)
+  {
+    const char* needle = haystack + n * (haystackLength / NumSamplesRare);
+    ranks     [numRare] = rarestByteRank(needle, RareLength);
+    timeRare  [numRare] = measure(searchNativeRareByte, numRuns, haystack, haystackLength, needle, RareLength, &numHits).median;
+    timeKernel[numRare] = measure(kernel,               numRuns, haystack, haystackLength, needle, RareLength, &numHits).median;
+    numRare++;
+  }
+  // try each rank as a threshold
+  double bestTotal = 0;
+  int threshold;
+  for (threshold = -1; threshold < 256; threshold++)
+  {
+    double total = 0;
+    for (n = 0; n < numRare; n++)
+      total += ranks[n] <= threshold ? timeRare[n] : timeKernel[n];
+    if (threshold == -1 || total < bestTotal)
+    {
+      bestTotal            = total;
+      profile.rareByteRank = threshold;
+    }
+  }
+  printf("rare byte threshold: rank %d\n", profile.rareByteRank);
+
+  printf("smallHaystack %lu, shortKernel %s, longNeedle %lu, rareByteRank %d\n",
+         (unsigned long)profile.smallHaystack, profile.shortKernel,
+         (unsigned long)profile.longNeedle, profile.rareByteRank);
+  if (!saveSearchProfile(&profile, filename))
+  {
+    printf("Failed to write profile %s\n", filename);
+    return -3;
+  }
+  return 0;
+}
+
+
+/// convert needle to hex string (needles may contain spaces, newlines or even zeros)
+static void toHex(char* hex, const char* needle, size_t needleLength)
+{
+  const char* digits = "0123456789abcdef";
+  size_t i;
+  for (i = 0; i < needleLength; i++)
+  {
+    *hex++ = digits[(unsigned char)needle[i] >> 4];
+    *hex++ = digits[(unsigned char)needle[i] & 15];
+  }
+  *hex = 0;
+}
+
+/// read baseline file, return number of entries or -1 on failure
+/** stores name and size of the measured file (dataSize is -1 if the baseline doesn't say) **/
+static int loadBaseline(const char* filename, BaselineEntry* entries, size_t maxEntries,
+                        char* dataName, size_t maxNameLength, long* dataSize)
+{
+  FILE* file = fopen(filename, "r");
+  if (!file)
+    return -1;
+
+  *dataName = 0;
+  *dataSize = -1;
+
+  size_t numEntries = 0;
+  char line[1024];
+  while (numEntries < maxEntries && fgets(line, sizeof(line), file))
+  {
+    // "# file name, size bytes, runs runs" (name may contain commas, the numbers don't)
+    if (strncmp(line, "# file ", 7) == 0)
+    {
+      char* runs = strrchr(line, ',');
+      if (runs)
+      {
+        *runs = 0;
+        char* size = strrchr(line, ',');
+        if (size && sscanf(size, ", %ld bytes", dataSize) == 1)
+        {
+          *size = 0;
+          strncpy(dataName, line + 7, maxNameLength - 1);
+          dataName[maxNameLength - 1] = 0;
+        }
+      }
+      continue;
+    }
+
+    // skip comments
+    if (line[0] == '#')
+      continue;
+
+    BaselineEntry* entry = &entries[numEntries];
+    if (sscanf(line, "%63s %512s %lf %lf %lf", entry->name, entry->needle,
+               &entry->measurement.median, &entry->measurement.low, &entry->measurement.high) == 5)
+      numEntries++;
+  }
+
+  fclose(file);
+  return (int)numEntries;
+}
+
+/// find algorithm/needle pair in baseline
+static const BaselineEntry* findBaseline(const BaselineEntry* entries, size_t numEntries,
+                                         const char* name, const char* hexNeedle)
+{
+  size_t i;
+  for (i = 0; i < numEntries; i++)
+    if (strcmp(entries[i].name, name) == 0 && strcmp(entries[i].needle, hexNeedle) == 0)
+      return &entries[i];
+  return NULL;
+}
+
+
+int main(int argc, char* argv[])
+{
+  const char* syntax = "Syntax: ./benchmark filename [needle ...] [--runs N] [--save baseline] [--compare baseline] [--threshold percent] [--latency] [--downclock] [--calibrate profile] [--analyze] [--jit]\n";
+  if (argc < 2)
+  {
+    printf("%s", syntax);
+    return -1;
+  }
+
+  // parse parameters
+  const size_t MaxNeedles = 32;
+  const char*  needles[MaxNeedles];
+  size_t       numNeedles   = 0;
+  unsigned int numRuns      = 15;
+  const char*  saveName     = NULL;
+  const char*  compareName  = NULL;
+  double       threshold    = 5; // percent
+  int          latency      = 0;
+  int          downclock    = 0;
+  const char*  profileName  = NULL;
+  int          analyze      = 0;
+  int          jit          = 0;
+  int i;
+  for (i = 2; i < argc; i++)
+  {
+    if      (strcmp(argv[i], "--runs")      == 0 && i + 1 < argc)
+      numRuns     = atoi(argv[++i]);
+    else if (strcmp(argv[i], "--save")      == 0 && i + 1 < argc)
+      saveName    = argv[++i];
+    else if (strcmp(argv[i], "--compare")   == 0 && i + 1 < argc)
+      compareName = argv[++i];
+    else if (strcmp(argv[i], "--threshold") == 0 && i + 1 < argc)
+      threshold   = atof(argv[++i]);
+    else if (strcmp(argv[i], "--latency")   == 0)
+      latency     = 1;
+    else if (strcmp(argv[i], "--downclock") == 0)
+      downclock   = 1;
+    else if (strcmp(argv[i], "--calibrate") == 0 && i + 1 < argc)
+      profileName = argv[++i];
+    else if (strcmp(argv[i], "--analyze")   == 0)
+      analyze     = 1;
+    else if (strcmp(argv[i], "--jit")       == 0)
+      jit         = 1;
+    else if (strncmp(argv[i], "--", 2) != 0 && numNeedles < MaxNeedles && strlen(argv[i]) <= 256)
+      needles[numNeedles++] = argv[i];
+    else
+    {
+      printf("%s", syntax);
+      return -2;
+    }
+  }
+  if (numRuns < 3)
+  {
+    printf("At least 3 runs required\n");
+    return -2;
+  }
+
+  // open file
+  FILE* file = fopen(argv[1], "rb");
+  if (!file)
+  {
+    printf("Failed to open file\n");
+    return -3;
+  }
+
+  // determine its filesize
+  fseek(file, 0, SEEK_END);
+  long filesize = ftell(file);
+  fseek(file, 0, SEEK_SET);
+  if (filesize == 0)
+  {
+    printf("Empty file\n");
+    return -4;
+  }
+
+  // allocate memory and read the whole file at once
+  char* data = (char*) malloc(filesize + 2);
+  if (!data)
+  {
+    printf("Out of memory\n");
+    return -5;
+  }
+  fread(data, filesize, 1, file);
+  fclose(file);
+
+  // pad data to avoid buffer overruns
+  data[filesize    ] = '\n';
+  data[filesize + 1] = 0;
+
+  const char*  haystack       = data;
+  const size_t haystackLength = filesize;
+
+  // rank bytes by their frequency in the first 64k of the file
+  trainByteFrequency(trainedFrequency, haystack, haystackLength < 65536 ? haystackLength : 65536);
+
+  // crossover points for selectSearchFunction
+  if (profileName)
+  {
+    int result = calibrate(haystack, haystackLength, numRuns, profileName);
+    free(data);
+    return result;
+  }
+
+  // no needles provided: take a few from the middle of the file (deterministic, therefore comparable across runs)
+  size_t needleLengths[MaxNeedles];
+  if (numNeedles == 0)
+  {
+    // tiny haystacks need short needles
+    const size_t defaultLengths[] = { 2, 4, 8, 16, 32, 64, 256 };
+    const size_t latencyLengths[] = { 4, 8, 16 };
+    const size_t* lengths    = latency ? latencyLengths : defaultLengths;
+    size_t        numLengths = latency ? sizeof(latencyLengths) / sizeof(latencyLengths[0])
+                                       : sizeof(defaultLengths) / sizeof(defaultLengths[0]);
+    size_t d;
+    for (d = 0; d < numLengths; d++)
+      if (lengths[d] <= haystackLength)
+      {
+        needleLengths[numNeedles] = lengths[d];
+        needles      [numNeedles] = haystack + (haystackLength - lengths[d]) / 2;
+        numNeedles++;
+      }
+  }
+  else
+  {
+    size_t n;
+    for (n = 0; n < numNeedles; n++)
+      needleLengths[n] = strlen(needles[n]);
+  }
+
+  // less noise if we don't hop between cores
+  cpu_set_t cpus;
+  CPU_ZERO(&cpus);
+  CPU_SET(0, &cpus);
+  sched_setaffinity(0, sizeof(cpus), &cpus);
+
+  // per-call latency on tiny haystacks instead of throughput
+  if (latency)
+  {
+    size_t n;
+    for (n = 0; n < numNeedles; n++)
+    {
+      printf("needle length %d\n", (int)needleLengths[n]);
+      benchmarkLatency(haystack, haystackLength, needles[n], needleLengths[n]);
+    }
+    free(data);
+    return 0;
+  }
+
+  // structure of each needle
+  if (analyze)
+  {
+    printf("%6s %7s %9s %9s %8s %8s %12s %12s %-18s %s\n", "length", "period", "critical", "distinct",
+           "entropy", "avgshift", "rarest rank", "2nd rank", "selected", "needle");
+    size_t n;
+    for (n = 0; n < numNeedles; n++)
+    {
+      NeedleAnalysis analysis;
+      analyzeNeedle(&analysis, needles[n], needleLengths[n]);
+
+      // name of the algorithm the selector picks for this haystack (default profile)
+      SearchFunction selected = selectSearchFunction(NULL, needles[n], needleLengths[n], haystackLength);
+      const char* selectedName = "?";
+      size_t a;
+      for (a = 0; a < NumAlgorithms; a++)
+        if (algorithms[a].function == selected)
+          selectedName = algorithms[a].name;
+
+      // show at most 20 bytes, replace control characters
+      char shown[21];
+      size_t i, numShown = needleLengths[n] < 20 ? needleLengths[n] : 20;
+      for (i = 0; i < numShown; i++)
+        shown[i] = (unsigned char)needles[n][i] < 32 ? '.' : needles[n][i];
+      shown[numShown] = 0;
+
+      printf("%6d %7d %9d %9d %8.3f %8.2f %12d %12d %-18s %s\n", (int)needleLengths[n],
+             (int)analysis.period, (int)analysis.criticalPosition, (int)analysis.numDistinct,
+             analysis.entropy / 256.0, analysis.averageShift / 256.0, analysis.rarestRank, analysis.secondRarestRank,
+             selectedName, shown);
+    }
+    free(data);
+    return 0;
+  }
+
+  // break-even of generated code
+  if (jit)
+  {
+    size_t n;
+    for (n = 0; n < numNeedles; n++)
+    {
+      printf("needle length %d\n", (int)needleLengths[n]);
+      benchmarkJit(haystack, haystackLength, needles[n], needleLengths[n]);
+    }
+    free(data);
+    return 0;
+  }
+
+  // clock rate changes caused by SIMD code
+  if (downclock)
+  {
+    size_t n;
+    for (n = 0; n < numNeedles; n++)
+    {
+      printf("needle length %d\n", (int)needleLengths[n]);
+      benchmarkDownclock(haystack, haystackLength, needles[n], needleLengths[n]);
+    }
+    free(data);
+    return 0;
+  }
+
+  // load baseline
+  const size_t   MaxEntries = 1024;
+  BaselineEntry* baseline   = NULL;
+  int            numBaseline = 0;
+  if (compareName)
+  {
+    baseline    = (BaselineEntry*)malloc(MaxEntries * sizeof(BaselineEntry));
+    char baselineName[1024];
+    long baselineSize;
+    numBaseline = baseline ? loadBaseline(compareName, baseline, MaxEntries,
+                                          baselineName, sizeof(baselineName), &baselineSize) : -1;
+    if (numBaseline < 0)
+    {
+      printf("Failed to read baseline\n");
+      return -3;
+    }
+
+    // timings of different inputs can't be compared (the same file may be reached by a different path, though)
+    if (baselineSize >= 0 && baselineSize != filesize)
+    {
+      printf("Baseline was measured on %s with %ld bytes, not %s with %ld bytes\n",
+             baselineName, baselineSize, argv[1], filesize);
+      free(baseline);
+      free(data);
+      return -3;
+    }
+    if (baselineSize < 0)
+      printf("Warning: baseline doesn't name its file, make sure it was measured on %s\n", argv[1]);
+    else if (strcmp(baselineName, argv[1]) != 0)
+      printf("Warning: baseline was measured on %s, comparing with %s (same size)\n", baselineName, argv[1]);
+  }
+
+  FILE* save = NULL;
+  if (saveName)
+  {
+    save = fopen(saveName, "w");
+    if (!save)
+    {
+      printf("Failed to create baseline\n");
+      return -3;
+    }
+    fprintf(save, "# file %s, %ld bytes, %u runs\n", argv[1], filesize, numRuns);
+    fprintf(save, "# algorithm needle(hex) median(ns) low(ns) high(ns)\n");
+  }
+
+  printf("%-20s %6s %8s %10s %10s %s\n", "algorithm", "length", "hits", "MB/s", "median ms", "95% interval");
+
+  unsigned int numRegressions = 0;
+  size_t n;
+  for (n = 0; n < numNeedles; n++)
+  {
+    char hexNeedle[2 * 256 + 1];
+    toHex(hexNeedle, needles[n], needleLengths[n]);
+
+    size_t a;
+    for (a = 0; a < NumAlgorithms; a++)
+    {
+      unsigned int numHits;
+      Measurement current = measure(algorithms[a].function, numRuns,
+                                    haystack, haystackLength, needles[n], needleLengths[n], &numHits);
+
+      printf("%-20s %6d %8u %10.1f %10.3f [%.3f, %.3f]",
+             algorithms[a].name, (int)needleLengths[n], numHits,
+             haystackLength / (current.median / 1e9) / (1 << 20),
+             current.median / 1e6, current.low / 1e6, current.high / 1e6);
+
+      if (save)
+        fprintf(save, "%s %s %.0f %.0f %.0f\n", algorithms[a].name, hexNeedle,
+                current.median, current.low, current.high);
+
+      // compare with baseline
+      if (baseline)
+      {
+        const BaselineEntry* entry = findBaseline(baseline, numBaseline, algorithms[a].name, hexNeedle);
+        if (!entry)
+          printf("  new");
+        else
+        {
+          double change = 100 * (current.median - entry->measurement.median) / entry->measurement.median;
+          // a regression must exceed the threshold and its confidence interval must not overlap with the baseline
+          if (change > threshold && current.low > entry->measurement.high)
+          {
+            printf("  REGRESSION %+.1f%%", change);
+            numRegressions++;
+          }
+          else
+            printf("  %+.1f%%", change);
+        }
+      }
+
+      printf("\n");
+    }
+  }
+
+  if (save)
+    fclose(save);
+  free(baseline);
+  free(data);
+
+  if (numRegressions > 0)
+  {
+    printf("%u regression(s) beyond %.1f%%\n", numRegressions, threshold);
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,350 @@
+// //////////////////////////////////////////////////////////
+// blockfilter.c
+// Copyright (c) 2014,2019 Stephan Brumme. All rights reserved.
+// see http://create.stephan-brumme.com/disclaimer.html
+//
+
+// compiles with: gcc -Wall -std=c99 (requires suffixarray.c, POSIX only: mmap)
+
+// files larger than 2 GB on 32 bit systems, mmap() isn't part of C99
+#ifndef _FILE_OFFSET_BITS
+#define _FILE_OFFSET_BITS 64
+#endif
+#ifndef _DEFAULT_SOURCE
+#define _DEFAULT_SOURCE
+#endif
+
+#include "blockfilter.h"
+#include "suffixarray.h" // mapFile
+
+#include <stdint.h>   // uint64_t
+#include <string.h>   // memcmp / memcpy / memset
+#include <stdlib.h>   // malloc / free
+#include <stdio.h>    // fopen / fwrite / rename
+#include <sys/mman.h> // munmap
+
+
+/// "MYBLOOM1" plus four 64 bit values
+static const size_t MagicSize   = 8;
+/// q-grams of 4 bytes
+static const size_t GramLength  = 4;
+/// filter has 1/64 of the block's size
+static const size_t FilterRatio = 64;
+
+
+/// layout of a filter file
+typedef struct
+{
+  uint64_t dataLength;
+  uint64_t blockSize;
+  uint64_t maxNeedle;
+  uint64_t numBlocks;
+} FilterHeader;
+
+struct BlockFilter
+{
+  const unsigned char* filters;
+  size_t               filterLength;
+  const char*          data;
+  size_t               dataLength;
+  FilterHeader         header;
+};
+
+struct BlockQuery
+{
+  /// non-zero if a block may contain the needle
+  unsigned char* candidates;
+  size_t         numBlocks;
+  size_t         blockSize;
+  size_t         needleLength;
+  size_t         dataLength;
+};
+
+
+/// bit of a 4-gram (stored big-endian in gram) in a filter with numBits bits
+static uint32_t gramBit(uint32_t gram, uint32_t numBits)
+{
+  // Fibonacci hashing, scaled to [0, numBits)
+  uint32_t hash = (uint32_t)(((uint64_t)gram * 0x9E3779B97F4A7C15ULL) >> 32);
+  return (uint32_t)(((uint64_t)hash * numBits) >> 32);
+}
+
+/// number of blocks of a file
+static size_t numBlocks(size_t dataLength, size_t blockSize)
+{
+  return (dataLength + blockSize - 1) / blockSize;
+}
+
+/// first byte after the area covered by a block's filter (may be beyond the end of the file)
+static uint64_t coverageEnd(const FilterHeader* header, uint64_t block)
+{
+  return (block + 1) * header->blockSize + header->maxNeedle - 1;
+}
+
+
+/// check header, returns 0 if invalid or the data file is shorter than before
+static int readHeader(FilterHeader* header, const unsigned char* filters, size_t filterLength, size_t dataLength)
+{
+  if (filterLength < MagicSize + sizeof(FilterHeader) || memcmp(filters, "MYBLOOM1", MagicSize) != 0)
+    return 0;
+
+  memcpy(header, filters + MagicSize, sizeof(FilterHeader));
+  return header->blockSize > 0 && header->blockSize % FilterRatio == 0 && header->maxNeedle > 0 &&
+         header->dataLength <= dataLength &&
+         header->numBlocks  == numBlocks((size_t)header->dataLength, (size_t)header->blockSize) &&
+         filterLength == MagicSize + sizeof(FilterHeader) + header->numBlocks * (header->blockSize / FilterRatio);
+}
+
+
+/// create or extend a filter file, blockSize must be a multiple of 64, returns 0 on failure
+int buildBlockFilter(const char* dataFilename, const char* filterFilename, size_t blockSize, size_t maxNeedle)
+{
+  // detect invalid input
+  if (!dataFilename || !filterFilename || blockSize == 0 || blockSize % FilterRatio != 0 || maxNeedle == 0 ||
+      blockSize / FilterRatio * 8 > 0xFFFFFFFF)
+    return 0;
+
+  const void* mapped;
+  size_t dataLength;
+  if (!mapFile(dataFilename, &mapped, &dataLength))
+    return 0;
+  const unsigned char* data = (const unsigned char*)mapped;
+
+  FilterHeader header;
+  header.dataLength = dataLength;
+  header.blockSize  = blockSize;
+  header.maxNeedle  = maxNeedle;
+  header.numBlocks  = numBlocks(dataLength, blockSize);
+  size_t   filterSize = blockSize / FilterRatio;
+  uint32_t numBits    = (uint32_t)(filterSize * 8);
+
+  unsigned char* filters = (unsigned char*)calloc((size_t)header.numBlocks + 1, filterSize);
+  int success = filters != NULL;
+
+  // reuse filters of an append-only file if their coverage is complete
+  uint64_t firstBlock = 0;
+  const void* previous = NULL;
+  size_t previousLength = 0;
+  FilterHeader old;
+  if (success && mapFile(filterFilename, &previous, &previousLength) &&
+      readHeader(&old, (const unsigned char*)previous, previousLength, dataLength) &&
+      old.blockSize == blockSize && old.maxNeedle == maxNeedle)
+  {
+    while (firstBlock < old.numBlocks && coverageEnd(&old, firstBlock) <= old.dataLength)
+      firstBlock++;
+    memcpy(filters, (const unsigned char*)previous + MagicSize + sizeof(FilterHeader), (size_t)firstBlock * filterSize);
+  }
+  if (previous)
+    munmap((void*)previous, previousLength);
+
+  // set one bit per 4-gram
+  uint64_t block;
+  for (block = firstBlock; success && block < header.numBlocks; block++)
+  {
+    unsigned char* filter = filters + block * filterSize;
+    size_t from = (size_t)(block * blockSize);
+    size_t to   = coverageEnd(&header, block) < dataLength ? (size_t)coverageEnd(&header, block) : dataLength;
+
+    uint32_t gram = 0;
+    size_t pos;
+    for (pos = from; pos < to; pos++)
+    {
+      gram = (gram << 8) | data[pos];
+      if (pos - from + 1 < GramLength)
+        continue;
+
+      uint32_t bit = gramBit(gram, numBits);
+      filter[bit / 8] |= 1 << (bit % 8);
+    }
+  }
+  if (data)
+    munmap((void*)data, dataLength);
+
+  // write to a temporary file and replace the previous filter afterwards
+  char* tempFilename = (char*)malloc(strlen(filterFilename) + 5);
+  success = success && tempFilename;
+  if (success)
+  {
+    strcpy(tempFilename, filterFilename);
+    strcat(tempFilename, ".tmp");
+
+    FILE* output = fopen(tempFilename, "wb");
+    success = output != NULL;
+    if (success)
+    {
+      success = fwrite("MYBLOOM1", MagicSize, 1, output) == 1 &&
+                fwrite(&header, sizeof(header), 1, output) == 1 &&
+                (header.numBlocks == 0 || fwrite(filters, (size_t)header.numBlocks * filterSize, 1, output) == 1);
+      success = fclose(output) == 0 && success;
+    }
+    success = success && rename(tempFilename, filterFilename) == 0;
+    if (!success)
+      remove(tempFilename);
+  }
+
+  free(tempFilename);
+  free(filters);
+  return success;
+}
+
+
+/// map filter and data file, returns NULL if they don't belong together (or on failure)
+BlockFilter* openBlockFilter(const char* filterFilename, const char* dataFilename)
+{
+  // detect invalid input
+  if (!filterFilename || !dataFilename)
+    return NULL;
+
+  BlockFilter* filter = (BlockFilter*)calloc(1, sizeof(BlockFilter));
+  if (!filter)
+    return NULL;
+
+  const void* mapped = NULL;
+  int success = mapFile(filterFilename, &mapped, &filter->filterLength);
+  filter->filters = (const unsigned char*)mapped;
+  mapped  = NULL;
+  success = success && mapFile(dataFilename, &mapped, &filter->dataLength);
+  filter->data    = (const char*)mapped;
+
+  // data may have been appended since the filter was built
+  success = success && readHeader(&filter->header, filter->filters, filter->filterLength, filter->dataLength);
+
+  if (!success)
+  {
+    closeBlockFilter(filter);
+    return NULL;
+  }
+  return filter;
+}
+
+
+/// unmap both files
+void closeBlockFilter(BlockFilter* filter)
+{
+  if (!filter)
+    return;
+
+  if (filter->filters)
+    munmap((void*)filter->filters, filter->filterLength);
+  if (filter->data)
+    munmap((void*)filter->data, filter->dataLength);
+  free(filter);
+}
+
+
+/// the memory-mapped data file
+const char* blockFilterData(const BlockFilter* filter, size_t* dataLength)
+{
+  if (!filter)
+    return NULL;
+
+  if (dataLength)
+    *dataLength = filter->dataLength;
+  return filter->data;
+}
+
+
+/// check all blocks, returns NULL if out of memory
+BlockQuery* compileBlockQuery(const BlockFilter* filter, const char* needle, size_t needleLength)
+{
+  // detect invalid input
+  if (!filter || (!needle && needleLength > 0))
+    return NULL;
+
+  BlockQuery* query = (BlockQuery*)malloc(sizeof(BlockQuery));
+  if (!query)
+    return NULL;
+
+  const FilterHeader* header = &filter->header;
+  query->blockSize    = (size_t)header->blockSize;
+  query->needleLength = needleLength;
+  query->dataLength   = filter->dataLength;
+  query->numBlocks    = numBlocks(filter->dataLength, query->blockSize);
+  // all blocks are candidates by default
+  query->candidates   = (unsigned char*)malloc(query->numBlocks + 1);
+  if (!query->candidates)
+  {
+    free(query);
+    return NULL;
+  }
+  memset(query->candidates, 1, query->numBlocks + 1);
+
+  // needle's 4-grams, only the first maxNeedle bytes are covered by each block
+  size_t checked = needleLength < header->maxNeedle ? needleLength : (size_t)header->maxNeedle;
+  if (checked < GramLength)
+    return query;
+
+  size_t   filterSize = query->blockSize / FilterRatio;
+  uint32_t numBits    = (uint32_t)(filterSize * 8);
+  size_t   numGrams   = checked - GramLength + 1;
+  uint32_t* bits = (uint32_t*)malloc(numGrams * sizeof(uint32_t));
+  if (!bits)
+  {
+    freeBlockQuery(query);
+    return NULL;
+  }
+  uint32_t gram = 0;
+  size_t i;
+  for (i = 0; i < checked; i++)
+  {
+    gram = (gram << 8) | (unsigned char)needle[i];
+    if (i + 1 >= GramLength)
+      bits[i + 1 - GramLength] = gramBit(gram, numBits);
+  }
+
+  // blocks whose coverage changed after the filter was built must be searched
+  const unsigned char* filters = filter->filters + MagicSize + sizeof(FilterHeader);
+  uint64_t block;
+  for (block = 0; block < header->numBlocks; block++)
+  {
+    if (coverageEnd(header, block) > header->dataLength && header->dataLength < filter->dataLength)
+      continue;
+
+    const unsigned char* current = filters + block * filterSize;
+    for (i = 0; i < numGrams; i++)
+      if (!(current[bits[i] / 8] & (1 << (bits[i] % 8))))
+      {
+        query->candidates[block] = 0;
+        break;
+      }
+  }
+
+  free(bits);
+  return query;
+}
+
+
+/// release memory
+void freeBlockQuery(BlockQuery* query)
+{
+  if (!query)
+    return;
+
+  free(query->candidates);
+  free(query);
+}
+
+
+/// next range [from, to) at or after offset which has to be searched (includes matches crossing its last block's end), returns 0 if none is left
+int nextBlockRange(const BlockQuery* query, size_t offset, size_t* from, size_t* to)
+{
+  if (!query || !from || !to || offset >= query->dataLength)
+    return 0;
+
+  // first candidate block
+  size_t block = offset / query->blockSize;
+  while (block < query->numBlocks && !query->candidates[block])
+    block++;
+  if (block == query->numBlocks)
+    return 0;
+
+  size_t start = block * query->blockSize;
+  *from = start > offset ? start : offset;
+
+  // and all following candidate blocks, plus the bytes needed by a match beginning in the last of them
+  while (block + 1 < query->numBlocks && query->candidates[block + 1])
+    block++;
+  size_t end = (block + 1) * query->blockSize + (query->needleLength > 0 ? query->needleLength - 1 : 0);
+  *to = end < query->dataLength ? end : query->dataLength;
+  return 1;
+}
@@ -0,0 +1,46 @@
+// //////////////////////////////////////////////////////////
+// blockfilter.h
+// Copyright (c) 2014,2019 Stephan Brumme. All rights reserved.
+// see http://create.stephan-brumme.com/disclaimer.html
+//
+
+#pragma once
+
+#include <stddef.h> // size_t
+
+// small sidecar file for huge append-only files (e.g. logs): a Bloom filter of all 4-grams per block,
+// blocks whose filter lacks any of the needle's 4-grams can't contain a match and aren't searched (or even read)
+//
+// the filter of each block has blockSize / 64 bytes (1.6% of the file) and a single hash function,
+// it covers all 4-grams starting in the block and its next maxNeedle - 1 bytes, thus matches crossing a block's end are found, too
+// (longer needles are checked with their first maxNeedle bytes)
+//
+// bytes appended after the filter was built are always searched, rebuilding the filter only reads the new blocks
+//
+// filter file layout (native byte order):
+// "MYBLOOM1", uint64_t dataLength, uint64_t blockSize, uint64_t maxNeedle, uint64_t numBlocks,
+// followed by numBlocks filters of blockSize / 64 bytes each
+
+/// create or extend a filter file, blockSize must be a multiple of 64, returns 0 on failure
+/** if the existing filter file has the same parameters and the data file didn't shrink then only blocks touched by new data are read **/
+int          buildBlockFilter (const char* dataFilename, const char* filterFilename, size_t blockSize, size_t maxNeedle);
+
+/// memory-mapped filter plus its data file
+typedef struct BlockFilter BlockFilter;
+
+/// map filter and data file, returns NULL if they don't belong together (or on failure)
+BlockFilter* openBlockFilter  (const char* filterFilename, const char* dataFilename);
+/// unmap both files
+void         closeBlockFilter (BlockFilter* filter);
+/// the memory-mapped data file
+const char*  blockFilterData  (const BlockFilter* filter, size_t* dataLength);
+
+/// blocks which may contain a needle
+typedef struct BlockQuery BlockQuery;
+
+/// check all blocks, returns NULL if out of memory
+BlockQuery*  compileBlockQuery(const BlockFilter* filter, const char* needle, size_t needleLength);
+/// release memory
+void         freeBlockQuery   (BlockQuery* query);
+/// next range [from, to) at or after offset which has to be searched (includes matches crossing its last block's end), returns 0 if none is left
+int          nextBlockRange   (const BlockQuery* query, size_t offset, size_t* from, size_t* to);
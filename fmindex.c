@@ -0,0 +1,342 @@
+// //////////////////////////////////////////////////////////
+// fmindex.c
+// Copyright (c) 2014,2019 Stephan Brumme. All rights reserved.
+// see http://create.stephan-brumme.com/disclaimer.html
+//
+
+// compiles with: gcc -Wall -std=c99
+
+#include "fmindex.h"
+
+#include <string.h> // memset
+#include <stdlib.h> // malloc / free
+
+
+// memory layout (all parts are 8-byte aligned):
+// uint64_t primary           row of the rotation starting at text position 0 (its BWT byte is the sentinel)
+// uint64_t counts[257]       first row of each byte's rotations (row 0 belongs to the sentinel)
+// uint64_t zeros[8]          number of zeros in each level of the wavelet matrix
+// uint64_t starts[256]       where each byte's range begins in the last level of the wavelet matrix
+// 8 bit vectors              wavelet matrix, most significant bit first
+// 1 bit vector               rows whose text position is a multiple of sampleRate
+// uint32_t samples[]         text positions of these rows
+//
+// bit vector: uint64_t words[numWords], uint32_t ranks[numBlocks] (number of ones before each 256 bit block)
+
+/// 4 words per rank block
+static const uint32_t WordsPerBlock = 4;
+static const uint32_t BitsPerBlock  = 256;
+/// primary + counts + zeros + starts
+static const size_t   FixedSize     = (1 + 257 + 8 + 256) * sizeof(uint64_t);
+
+
+/// pointers to a bit vector's parts
+typedef struct
+{
+  uint64_t* words;
+  uint32_t* ranks;
+} BitVector;
+
+/// pointers to all parts of an FM-index
+typedef struct
+{
+  uint64_t* primary;
+  uint64_t* counts;
+  uint64_t* zeros;
+  uint64_t* starts;
+  BitVector levels[8];
+  BitVector sampled;
+  uint32_t* samples;
+} FMLayout;
+
+
+/// round up to a multiple of 8
+static size_t align8(size_t size)
+{
+  return (size + 7) & ~(size_t)7;
+}
+
+/// number of 64 bit words, a multiple of WordsPerBlock
+static size_t numWords(uint32_t numBits)
+{
+  size_t words = ((size_t)numBits + 63) / 64;
+  return (words + WordsPerBlock - 1) / WordsPerBlock * WordsPerBlock;
+}
+
+/// bytes of a bit vector including its rank directory
+static size_t bitVectorSize(uint32_t numBits)
+{
+  size_t words = numWords(numBits);
+  return words * sizeof(uint64_t) + align8((words / WordsPerBlock + 1) * sizeof(uint32_t));
+}
+
+/// locate the parts of a bit vector, returns pointer to the next part
+static unsigned char* mapBitVector(BitVector* vector, unsigned char* memory, uint32_t numBits)
+{
+  vector->words = (uint64_t*)memory;
+  vector->ranks = (uint32_t*)(memory + numWords(numBits) * sizeof(uint64_t));
+  return memory + bitVectorSize(numBits);
+}
+
+/// locate all parts of an FM-index
+static void mapLayout(FMLayout* layout, const void* fmIndex, uint32_t length)
+{
+  uint32_t numRows = length + 1;
+  unsigned char* memory = (unsigned char*)fmIndex;
+  layout->primary = (uint64_t*)memory;
+  layout->counts  = layout->primary + 1;
+  layout->zeros   = layout->counts  + 257;
+  layout->starts  = layout->zeros   + 8;
+  memory += FixedSize;
+
+  int level;
+  for (level = 0; level < 8; level++)
+    memory = mapBitVector(&layout->levels[level], memory, numRows);
+  memory = mapBitVector(&layout->sampled, memory, numRows);
+  layout->samples = (uint32_t*)memory;
+}
+
+
+/// number of set bits
+static uint32_t popCount(uint64_t x)
+{
+#ifdef __GNUC__
+  return (uint32_t)__builtin_popcountll(x);
+#else
+  x =  x - ((x >> 1) & 0x5555555555555555ULL);
+  x = (x & 0x3333333333333333ULL) + ((x >> 2) & 0x3333333333333333ULL);
+  x = (x + (x >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+  return (uint32_t)((x * 0x0101010101010101ULL) >> 56);
+#endif
+}
+
+/// number of ones in bits [0, pos)
+static uint32_t rank1(const BitVector* vector, uint32_t pos)
+{
+  uint32_t block  = pos / BitsPerBlock;
+  uint32_t result = vector->ranks[block];
+  uint32_t word   = block * WordsPerBlock;
+  for (; word < pos / 64; word++)
+    result += popCount(vector->words[word]);
+  if (pos % 64 != 0)
+    result += popCount(vector->words[word] & (((uint64_t)1 << (pos % 64)) - 1));
+  return result;
+}
+
+/// single bit
+static int getBit(const BitVector* vector, uint32_t pos)
+{
+  return (int)((vector->words[pos / 64] >> (pos % 64)) & 1);
+}
+
+/// fill rank directory
+static void buildRanks(BitVector* vector, uint32_t numBits)
+{
+  size_t words = numWords(numBits);
+  uint32_t sum = 0;
+  size_t word;
+  for (word = 0; word < words; word++)
+  {
+    if (word % WordsPerBlock == 0)
+      vector->ranks[word / WordsPerBlock] = sum;
+    sum += popCount(vector->words[word]);
+  }
+  vector->ranks[words / WordsPerBlock] = sum;
+}
+
+
+/// BWT byte of a row and the row's position in the last level of the wavelet matrix
+static uint32_t accessByte(const FMLayout* layout, unsigned char* byte, uint32_t row)
+{
+  unsigned char value = 0;
+  int level;
+  for (level = 0; level < 8; level++)
+  {
+    const BitVector* vector = &layout->levels[level];
+    int bit = getBit(vector, row);
+    value = (unsigned char)((value << 1) | bit);
+    row   = bit ? (uint32_t)layout->zeros[level] + rank1(vector, row) : row - rank1(vector, row);
+  }
+
+  *byte = value;
+  return row;
+}
+
+/// how often byte occurs in BWT rows [0, row)
+static uint32_t rankByte(const FMLayout* layout, unsigned char byte, uint32_t row)
+{
+  // follow the byte's bits, afterwards each byte occupies a contiguous range of the last level
+  uint32_t position = row;
+  int level;
+  for (level = 0; level < 8; level++)
+  {
+    const BitVector* vector = &layout->levels[level];
+    position = (byte >> (7 - level)) & 1 ? (uint32_t)layout->zeros[level] + rank1(vector, position)
+                                         : position - rank1(vector, position);
+  }
+  uint32_t result = position - (uint32_t)layout->starts[byte];
+
+  // the sentinel is stored as a zero
+  if (byte == 0 && *layout->primary < row)
+    result--;
+  return result;
+}
+
+/// LF mapping: row of the rotation that starts one byte earlier in the text (not for the primary row)
+static uint32_t previousRow(const FMLayout* layout, uint32_t row)
+{
+  unsigned char byte;
+  uint32_t position = accessByte(layout, &byte, row);
+  uint32_t result   = (uint32_t)layout->counts[byte] + position - (uint32_t)layout->starts[byte];
+  // the sentinel is stored as a zero
+  if (byte == 0 && *layout->primary < row)
+    result--;
+  return result;
+}
+
+
+/// bytes needed by an FM-index of a text with length bytes
+size_t fmIndexSize(uint32_t length, uint32_t sampleRate)
+{
+  if (sampleRate == 0)
+    return 0;
+
+  uint32_t numRows    = length + 1;
+  size_t   numSamples = ((size_t)length + sampleRate - 1) / sampleRate;
+  return FixedSize + 9 * bitVectorSize(numRows) + align8(numSamples * sizeof(uint32_t));
+}
+
+
+/// build FM-index from text and its suffix array (fmIndex must hold fmIndexSize bytes and be 8-byte aligned), returns 0 on failure
+int createFMIndex(void* fmIndex, const unsigned char* text, const uint32_t* suffixArray,
+                  uint32_t length, uint32_t sampleRate)
+{
+  // detect invalid input
+  if (!fmIndex || !text || !suffixArray || sampleRate == 0 || length == 0xFFFFFFFF)
+    return 0;
+
+  uint32_t numRows = length + 1;
+  unsigned char* current = (unsigned char*)malloc(numRows);
+  unsigned char* next    = (unsigned char*)malloc(numRows);
+  if (!current || !next)
+  {
+    free(current);
+    free(next);
+    return 0;
+  }
+
+  memset(fmIndex, 0, fmIndexSize(length, sampleRate));
+  FMLayout layout;
+  mapLayout(&layout, fmIndex, length);
+
+  // Burrows-Wheeler transform: row 0 is the sentinel's rotation, row i + 1 belongs to suffixArray[i]
+  uint32_t row;
+  for (row = 0; row < numRows; row++)
+  {
+    uint32_t pos = row == 0 ? length : suffixArray[row - 1];
+    if (pos == 0)
+    {
+      *layout.primary = row;
+      current[row]    = 0;
+    }
+    else
+      current[row] = text[pos - 1];
+
+    // sample text positions
+    if (pos % sampleRate == 0 && pos < length)
+      layout.sampled.words[row / 64] |= (uint64_t)1 << (row % 64);
+  }
+  buildRanks(&layout.sampled, numRows);
+  for (row = 0; row < numRows; row++)
+  {
+    uint32_t pos = row == 0 ? length : suffixArray[row - 1];
+    if (pos % sampleRate == 0 && pos < length)
+      layout.samples[rank1(&layout.sampled, row)] = pos;
+  }
+
+  // first row of each byte
+  uint64_t histogram[256];
+  memset(histogram, 0, sizeof(histogram));
+  uint32_t i;
+  for (i = 0; i < length; i++)
+    histogram[text[i]]++;
+  layout.counts[0] = 1;
+  int c;
+  for (c = 0; c < 256; c++)
+    layout.counts[c + 1] = layout.counts[c] + histogram[c];
+
+  // wavelet matrix: split by the current bit, zeros go first (stable), afterwards all equal bytes are adjacent
+  int level;
+  for (level = 0; level < 8; level++)
+  {
+    BitVector* vector = &layout.levels[level];
+    int shift = 7 - level;
+    uint32_t numZeros = 0;
+    for (row = 0; row < numRows; row++)
+      if ((current[row] >> shift) & 1)
+        vector->words[row / 64] |= (uint64_t)1 << (row % 64);
+      else
+        numZeros++;
+    buildRanks(vector, numRows);
+    layout.zeros[level] = numZeros;
+
+    uint32_t zero = 0, one = numZeros;
+    for (row = 0; row < numRows; row++)
+      if ((current[row] >> shift) & 1)
+        next[one++]  = current[row];
+      else
+        next[zero++] = current[row];
+
+    unsigned char* swap = current;
+    current = next;
+    next    = swap;
+  }
+  for (row = numRows; row-- > 0; )
+    layout.starts[current[row]] = row;
+
+  free(current);
+  free(next);
+  return 1;
+}
+
+
+/// backward search: rows [first, last) of the sorted rotations start with needle, returns number of matches
+uint32_t fmIndexCount(const void* fmIndex, uint32_t length, const char* needle, size_t needleLength,
+                      uint32_t* first, uint32_t* last)
+{
+  FMLayout layout;
+  mapLayout(&layout, fmIndex, length);
+
+  // all rows match an empty needle
+  uint32_t begin = 0, end = length + 1;
+  while (needleLength > 0 && begin < end)
+  {
+    unsigned char byte = (unsigned char)needle[--needleLength];
+    begin = (uint32_t)layout.counts[byte] + rankByte(&layout, byte, begin);
+    end   = (uint32_t)layout.counts[byte] + rankByte(&layout, byte, end);
+  }
+
+  if (first)
+    *first = begin;
+  if (last)
+    *last  = end;
+  return end - begin;
+}
+
+
+/// text position of a row
+uint32_t fmIndexLocate(const void* fmIndex, uint32_t length, uint32_t row)
+{
+  FMLayout layout;
+  mapLayout(&layout, fmIndex, length);
+
+  // walk backwards through the text (LF mapping) until a sampled position is found
+  uint32_t steps = 0;
+  while (!getBit(&layout.sampled, row))
+  {
+    row = previousRow(&layout, row);
+    steps++;
+  }
+
+  return layout.samples[rank1(&layout.sampled, row)] + steps;
+}
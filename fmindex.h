@@ -0,0 +1,29 @@
+// //////////////////////////////////////////////////////////
+// fmindex.h
+// Copyright (c) 2014,2019 Stephan Brumme. All rights reserved.
+// see http://create.stephan-brumme.com/disclaimer.html
+//
+
+#pragma once
+
+#include <stddef.h> // size_t
+#include <stdint.h> // uint32_t
+
+// FM-index (Ferragina and Manzini) of a text with up to 2^32 - 2 bytes:
+// Burrows-Wheeler transform stored as a wavelet matrix (8 bit vectors with rank directories),
+// counting all matches takes O(m) rank operations, each match is located in at most sampleRate steps
+// because the suffix array is sampled at every text position that is a multiple of sampleRate
+//
+// about 1.27 + 4 / sampleRate bytes per text byte (suffix array: 4 bytes per text byte)
+// the text itself isn't stored, all data is in a single block of memory (can be memory-mapped)
+
+/// bytes needed by an FM-index of a text with length bytes
+size_t   fmIndexSize  (uint32_t length, uint32_t sampleRate);
+/// build FM-index from text and its suffix array (fmIndex must hold fmIndexSize bytes and be 8-byte aligned), returns 0 on failure
+int      createFMIndex(void* fmIndex, const unsigned char* text, const uint32_t* suffixArray,
+                       uint32_t length, uint32_t sampleRate);
+/// backward search: rows [first, last) of the sorted rotations start with needle, returns number of matches
+uint32_t fmIndexCount (const void* fmIndex, uint32_t length, const char* needle, size_t needleLength,
+                       uint32_t* first, uint32_t* last);
+/// text position of a row (at most sampleRate steps)
+uint32_t fmIndexLocate(const void* fmIndex, uint32_t length, uint32_t row);
@@ -0,0 +1,215 @@
+// //////////////////////////////////////////////////////////
+// mycodesearch.c
+// Copyright (c) 2014,2019 Stephan Brumme. All rights reserved.
+// see http://create.stephan-brumme.com/disclaimer.html
+//
+
+// gcc -O3 -std=c99 -Wall -pedantic search.c trigramindex.c mycodesearch.c -o mycodesearch
+// ./mycodesearch --update indexfile path [path ...]     indexes all files in these paths (only new or modified files are read)
+// ./mycodesearch searchphrase indexfile [-c] [-n] [-l]  prints all matching lines, prefixed by their filename
+// only files containing all trigrams of the search phrase are opened
+
+#ifdef _MSC_VER
+#define _CRT_SECURE_NO_WARNINGS
+#endif
+
+#include "search.h"
+#include "trigramindex.h"
+
+#include <string.h> // strcmp()
+#include <stdio.h>  // printf()
+#include <stdlib.h> // malloc()
+
+
+/// search a single file, returns number of matching lines or -1 if it can't be read
+static long searchFile(const char* filename, const char* needle, size_t needleLength,
+                       const SearchProfile* profile, const NeedleAnalysis* analysis,
+                       int countOnly, int showLineNumbers, int listFiles)
+{
+  // file may have been deleted since the last update
+  FILE* file = fopen(filename, "rb");
+  if (!file)
+    return -1;
+
+  fseek(file, 0, SEEK_END);
+  long filesize = ftell(file);
+  fseek(file, 0, SEEK_SET);
+  if (filesize <= 0)
+  {
+    fclose(file);
+    return filesize == 0 ? 0 : -1;
+  }
+
+  char* data = (char*) malloc(filesize + 2);
+  if (!data)
+  {
+    fclose(file);
+    return -1;
+  }
+  size_t haystackLength = fread(data, 1, filesize, file);
+  fclose(file);
+  // pad data to avoid buffer overruns
+  data[haystackLength    ] = '\n';
+  data[haystackLength + 1] = 0;
+
+  // each file has a different size, let the selector decide
+  SearchFunction selected = selectSearchFunctionFromAnalysis(profile, analysis, needleLength, haystackLength);
+
+  const char* haystack    = data;
+  const char* haystackEnd = haystack + haystackLength;
+  long        numHits     = 0;
+  size_t      lineNumber  = 1;
+  const char* lineCounted = haystack;
+  const char* current     = haystack;
+  for (;;)
+  {
+    current = selected(current, haystackEnd - current, needle, needleLength);
+    if (!current)
+      break;
+
+    numHits++;
+    // one match is enough
+    if (listFiles)
+    {
+      printf("%s\n", filename);
+      break;
+    }
+
+    // find end of line
+    const char* right = current;
+    while (right != haystackEnd && *right != '\n')
+      right++;
+
+    if (countOnly)
+    {
+      current = right;
+      continue;
+    }
+
+    // find beginning of line
+    const char* left = current;
+    while (left != haystack && left[-1] != '\n')
+      left--;
+
+    printf("%s:", filename);
+    if (showLineNumbers)
+    {
+      lineNumber += countNewlines(lineCounted, left - lineCounted);
+      lineCounted = left;
+      printf("%lu:", (unsigned long)lineNumber);
+    }
+    fwrite(left, right - left, 1, stdout);
+    putchar('\n');
+
+    // don't search this line anymore
+    current = right;
+  }
+
+  free(data);
+  return numHits;
+}
+
+
+int main(int argc, char* argv[])
+{
+  const char* syntax = "Syntax: ./mycodesearch --update indexfile path [path ...]\n"
+                       "        ./mycodesearch searchphrase indexfile [-c] [-n] [-l]\n";
+  if (argc < 3)
+  {
+    printf("%s", syntax);
+    return -1;
+  }
+
+  // create or update index
+  if (strcmp(argv[1], "--update") == 0)
+  {
+    if (argc < 4)
+    {
+      printf("%s", syntax);
+      return -1;
+    }
+
+    size_t numScanned;
+    if (!updateTrigramIndex(argv[2], (const char* const*)(argv + 3), argc - 3, &numScanned))
+    {
+      printf("Failed to update index\n");
+      return -3;
+    }
+
+    TrigramIndex* index = openTrigramIndex(argv[2]);
+    printf("%lu files indexed, %lu of them were read\n",
+           (unsigned long)trigramIndexNumFiles(index), (unsigned long)numScanned);
+    closeTrigramIndex(index);
+    return 0;
+  }
+
+  // count matching lines, show line numbers or only list filenames
+  int countOnly       = 0;
+  int showLineNumbers = 0;
+  int listFiles       = 0;
+  int i;
+  for (i = 3; i < argc; i++)
+  {
+    if      (strcmp(argv[i], "-c") == 0)
+      countOnly       = 1;
+    else if (strcmp(argv[i], "-n") == 0)
+      showLineNumbers = 1;
+    else if (strcmp(argv[i], "-l") == 0)
+      listFiles       = 1;
+    else
+    {
+      printf("%s", syntax);
+      return -2;
+    }
+  }
+
+  const char*  needle       = argv[1];
+  const size_t needleLength = strlen(needle);
+  if (needleLength == 0)
+  {
+    printf("Empty search phrase\n");
+    return -2;
+  }
+
+  // thresholds measured by ./benchmark --calibrate
+  SearchProfile profile;
+  defaultSearchProfile(&profile);
+  const char* profileName = getenv("MYGREP_PROFILE");
+  if (profileName && !loadSearchProfile(&profile, profileName))
+  {
+    printf("Failed to open profile\n");
+    return -3;
+  }
+  // the needle stays the same for all files
+  NeedleAnalysis analysis;
+  analyzeNeedle(&analysis, needle, needleLength);
+
+  TrigramIndex* index = openTrigramIndex(argv[2]);
+  if (!index)
+  {
+    printf("Failed to open index\n");
+    return -3;
+  }
+
+  // only candidate files are searched
+  size_t    numCandidates;
+  uint32_t* candidates = queryTrigramIndex(index, needle, needleLength, &numCandidates);
+  long      numHits    = 0;
+  size_t    candidate;
+  for (candidate = 0; candidate < numCandidates; candidate++)
+  {
+    long hits = searchFile(trigramIndexFilename(index, candidates[candidate]), needle, needleLength,
+                           &profile, &analysis, countOnly, showLineNumbers, listFiles);
+    if (hits > 0)
+      numHits += hits;
+  }
+
+  if (countOnly && !listFiles)
+    printf("%ld\n", numHits);
+
+  free(candidates);
+  closeTrigramIndex(index);
+
+  // exit with error code 1 if nothing found
+  return numHits == 0 ? 1 : 0;
+}
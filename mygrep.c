@@ -4,8 +4,8 @@
 // see http://create.stephan-brumme.com/disclaimer.html
 //
 
-// gcc -O3 -std=c99 -Wall -pedantic search.c mygrep.c -o mygrep
-// file size limited to available memory size because whole file is loaded into RAM
+// gcc -O3 -std=c99 -Wall -pedantic -pthread search.c myregex.c suffixarray.c fmindex.c blockfilter.c mygrep.c -o mygrep
+// file size limited to available memory size because whole file is loaded into RAM (except for --index and --bloom, see myindex.c)
 
 // enable GNU extensions, such as memmem()
 #ifndef _GNU_SOURCE
@@ -19,6 +19,9 @@
 #endif
 
 #include "search.h"
+#include "myregex.h"
+#include "suffixarray.h"
+#include "blockfilter.h"
 
 #include <string.h> // memmem()
 #include <stdio.h>  // printf()
@@ -28,14 +31,37 @@
 enum Algorithm
 {
   UseBest
+  , UseSelected
   , UseStrStr
   , UseMemMem
   , UseSimple
   , UseNative
+  , UseNativeRareByte
+  , UseSWAR
+  , UseSSE42
+  , UseAVX2
+  , UseAVX512
   , UseKnuthMorrisPratt
   , UseBoyerMooreHorspool
+  , UseBoyerMoore
+  , UseHash3
+  , UseHash5
+  , UseHash8
   , UseBitap
   , UseRabinKarp
+  , UseRabinKarp64
+  // ignore ASCII case
+  , UseSWARNoCase
+  , UseAVX2NoCase
+  , UseBoyerMooreHorspoolNoCase
+  , UseBitapNoCase
+  , UseUtf8
+  // needle with wildcards and sets of bytes
+  , UseBitapPattern
+  // simple regular expressions
+  , UseRegex
+  // suffix array built by myindex
+  , UseIndex
 } algorithm;
 
 enum
@@ -46,42 +72,84 @@ enum
 
 int main(int argc, char* argv[])
 {
-  const char* syntax = "Syntax: ./mygrep searchphrase filename [--native|--memmem|--strstr|--simple|--knuthmorrispratt|--boyermoorehorspool|--bitap|--rabinkarp] [-c]\n";
-  if (argc < 3 || argc > 5)
+  const char* syntax = "Syntax: ./mygrep searchphrase filename [--native|--rarebyte|--swar|--sse42|--avx2|--avx512|--memmem|--strstr|--simple|--knuthmorrispratt|--boyermoorehorspool|--boyermoore|--hash3|--hash5|--hash8|--bitap|--rabinkarp|--rabinkarp64|--utf8|--wildcard|-E|--index indexfile] [--bloom filterfile] [-c] [-n] [-i]\n";
+  if (argc < 3)
   {
     printf("%s", syntax);
     return -1;
   }
 
-  // don't show lines, just count them
+  // show lines (optionally with line numbers) or just count them
   display = ShowLines;
-  if (argc == 5 && strcmp(argv[4], "-c")  == 0)
-    display = ShowCountOnly;
+  int showLineNumbers = 0;
+  // case-insensitive search (ASCII only)
+  int ignoreCase      = 0;
+  // created by ./myindex
+  const char* indexName  = NULL;
+  // created by ./myindex --bloom
+  const char* filterName = NULL;
 
   // use safer memmem() by default
   algorithm = UseBest;
-  if (argc >= 4)
+  int i;
+  for (i = 3; i < argc; i++)
   {
-    if      (strcmp(argv[3], "--native") == 0)
+    const char* option = argv[i];
+    if      (strcmp(option, "--native") == 0)
       algorithm = UseNative;
-    else if (strcmp(argv[3], "--memmem") == 0)
+    else if (strcmp(option, "--rarebyte") == 0)
+      algorithm = UseNativeRareByte;
+    else if (strcmp(option, "--swar")   == 0)
+      algorithm = UseSWAR;
+    else if (strcmp(option, "--sse42")  == 0)
+      algorithm = UseSSE42;
+    else if (strcmp(option, "--avx2")   == 0)
+      algorithm = UseAVX2;
+    else if (strcmp(option, "--avx512") == 0)
+      algorithm = UseAVX512;
+    else if (strcmp(option, "--memmem") == 0)
       algorithm = UseMemMem;
-    else if (strcmp(argv[3], "--strstr") == 0) // be careful: buffer overruns possible !!!
+    else if (strcmp(option, "--strstr") == 0) // be careful: buffer overruns possible !!!
       algorithm = UseStrStr;
-    else if (strcmp(argv[3], "--simple") == 0)
+    else if (strcmp(option, "--simple") == 0)
       algorithm = UseSimple;
-    else if (strcmp(argv[3], "--knuthmorrispratt")   == 0 ||
-             strcmp(argv[3], "--kmp")    == 0)
+    else if (strcmp(option, "--knuthmorrispratt")   == 0 ||
+             strcmp(option, "--kmp")    == 0)
       algorithm = UseKnuthMorrisPratt;
-    else if (strcmp(argv[3], "--boyermoorehorspool") == 0 ||
-             strcmp(argv[3], "--bmh")    == 0)
+    else if (strcmp(option, "--boyermoorehorspool") == 0 ||
+             strcmp(option, "--bmh")    == 0)
       algorithm = UseBoyerMooreHorspool;
-    else if (strcmp(argv[3], "--bitap")  == 0)
+    else if (strcmp(option, "--boyermoore") == 0 ||
+             strcmp(option, "--bm")     == 0)
+      algorithm = UseBoyerMoore;
+    else if (strcmp(option, "--hash3")  == 0)
+      algorithm = UseHash3;
+    else if (strcmp(option, "--hash5")  == 0)
+      algorithm = UseHash5;
+    else if (strcmp(option, "--hash8")  == 0)
+      algorithm = UseHash8;
+    else if (strcmp(option, "--bitap")  == 0)
       algorithm = UseBitap;
-    else if (strcmp(argv[3], "--rabinkarp") == 0)
+    else if (strcmp(option, "--rabinkarp") == 0)
       algorithm = UseRabinKarp;
-    else if (strcmp(argv[3], "-c")       == 0)
+    else if (strcmp(option, "--rabinkarp64") == 0)
+      algorithm = UseRabinKarp64;
+    else if (strcmp(option, "--utf8")   == 0)
+      algorithm = UseUtf8;
+    else if (strcmp(option, "--wildcard") == 0)
+      algorithm = UseBitapPattern;
+    else if (strcmp(option, "-E")       == 0)
+      algorithm = UseRegex;
+    else if (strcmp(option, "--index")  == 0 && i + 1 < argc)
+      indexName  = argv[++i];
+    else if (strcmp(option, "--bloom")  == 0 && i + 1 < argc)
+      filterName = argv[++i];
+    else if (strcmp(option, "-c")       == 0)
       display = ShowCountOnly;
+    else if (strcmp(option, "-n")       == 0)
+      showLineNumbers = 1;
+    else if (strcmp(option, "-i")       == 0)
+      ignoreCase      = 1;
     else
     {
       printf("%s", syntax);
@@ -89,50 +157,134 @@ int main(int argc, char* argv[])
     }
   }
 
-  // open file
-  FILE* file = fopen(argv[2], "rb");
-  if (!file)
-  {
-    printf("Failed to open file\n");
-    return -3;
-  }
+  // what  we look for
+  const char*  needle         = argv[1];
+  const size_t needleLength   = strlen(needle);
+
+  // where we look for
+  char*        data           = NULL;
+  const char*  haystack       = NULL;
+  size_t       haystackLength = 0;
 
-  // determine its filesize
-  fseek(file, 0, SEEK_END);
-  long filesize = ftell(file);
-  fseek(file, 0, SEEK_SET);
-  if (filesize == 0)
+  // suffix array: memory-mapped file, all matches are known in advance
+  SuffixIndex* index           = NULL;
+  size_t*      indexMatches    = NULL;
+  size_t       numIndexMatches = 0;
+  size_t       nextIndexMatch  = 0;
+  // Bloom filters: memory-mapped file, blocks which can't contain needle are skipped (and never read from disk)
+  BlockFilter* filter     = NULL;
+  BlockQuery*  blockQuery = NULL;
+  if (indexName)
   {
-    printf("Empty file\n");
-    return -4;
-  }
+    if (algorithm != UseBest || ignoreCase || filterName)
+    {
+      printf("--index can't be combined with other algorithms or -i\n");
+      return -2;
+    }
 
-  // allocate memory and read the whole file at once
-  char* data = (char*) malloc(filesize + 2);
-  if (!data)
+    index = openIndex(indexName, argv[2]);
+    if (!index)
+    {
+      printf("Failed to open index (or it doesn't belong to the file)\n");
+      return -3;
+    }
+    haystack = indexData(index, &haystackLength);
+    if (haystackLength == 0)
+    {
+      printf("Empty file\n");
+      return -4;
+    }
+    if (needleLength > indexMaxNeedle(index))
+    {
+      printf("Index supports only search phrases up to %d bytes\n", (int)indexMaxNeedle(index));
+      return -2;
+    }
+
+    indexMatches = queryIndex(index, needle, needleLength, &numIndexMatches);
+    algorithm    = UseIndex;
+  }
+  else if (filterName)
   {
-    printf("Out of memory\n");
-    return -5;
+    // filters contain exact q-grams
+    if (ignoreCase || algorithm == UseStrStr || algorithm == UseUtf8 || algorithm == UseBitapPattern || algorithm == UseRegex)
+    {
+      printf("--bloom can't be combined with --strstr, --utf8, --wildcard, -E or -i\n");
+      return -2;
+    }
+
+    filter = openBlockFilter(filterName, argv[2]);
+    if (!filter)
+    {
+      printf("Failed to open filter (or it doesn't belong to the file)\n");
+      return -3;
+    }
+    haystack = blockFilterData(filter, &haystackLength);
+    if (haystackLength == 0)
+    {
+      printf("Empty file\n");
+      return -4;
+    }
+
+    blockQuery = compileBlockQuery(filter, needle, needleLength);
+    if (!blockQuery)
+    {
+      printf("Out of memory\n");
+      return -5;
+    }
   }
-  fread(data, filesize, 1, file);
-  fclose(file);
+  else
+  {
+    // open file
+    FILE* file = fopen(argv[2], "rb");
+    if (!file)
+    {
+      printf("Failed to open file\n");
+      return -3;
+    }
 
-  // pad data to avoid buffer overruns
-  data[filesize    ] = '\n';
-  data[filesize + 1] = 0;
+    // determine its filesize
+    fseek(file, 0, SEEK_END);
+    long filesize = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    if (filesize == 0)
+    {
+      printf("Empty file\n");
+      return -4;
+    }
 
-  // what  we look for
-  const char*  needle         = argv[1];
-  const size_t needleLength   = strlen(needle);
-  // where we look for
-  const char*  haystack       = data;
-  const size_t haystackLength = filesize;
+    // allocate memory and read the whole file at once
+    data = (char*) malloc(filesize + 2);
+    if (!data)
+    {
+      printf("Out of memory\n");
+      return -5;
+    }
+    fread(data, filesize, 1, file);
+    fclose(file);
+
+    // pad data to avoid buffer overruns
+    data[filesize    ] = '\n';
+    data[filesize + 1] = 0;
+
+    haystack       = data;
+    haystackLength = filesize;
+  }
 
   // fence
   const char*  haystackEnd    = haystack + haystackLength;
 
-  // "native" and "Boyer-Moore-Horspool" are in almost all cases the best choice
-  if (algorithm == UseBest)
+  // non-ASCII needles and "ss" (could be written as ß) require UTF-8 case folding
+  if (ignoreCase && algorithm == UseBest)
+  {
+    size_t i;
+    for (i = 0; i < needleLength; i++)
+      if ((unsigned char)needle[i] >= 0x80 ||
+          (i > 0 && (needle[i - 1] | 0x20) == 's' && (needle[i] | 0x20) == 's'))
+        algorithm = UseUtf8;
+  }
+
+  // case-insensitive: "native" and "Boyer-Moore-Horspool" are in almost all cases the best choice
+  if (algorithm == UseBest && ignoreCase)
   {
     // when needle is longer than about 16 bytes, Boyer-Moore-Horspool is faster
     if (needleLength <= 16)
@@ -141,15 +293,121 @@ int main(int argc, char* argv[])
       algorithm = UseBoyerMooreHorspool;
   }
 
+  // else let the selector decide, based on thresholds measured by ./benchmark --calibrate
+  SearchFunction selected = NULL;
+  if (algorithm == UseBest)
+  {
+    SearchProfile profile;
+    defaultSearchProfile(&profile);
+    const char* profileName = getenv("MYGREP_PROFILE");
+    if (profileName && !loadSearchProfile(&profile, profileName))
+    {
+      printf("Failed to open profile\n");
+      free(data);
+      return -3;
+    }
+
+    selected  = selectSearchFunction(&profile, needle, needleLength, haystackLength);
+    algorithm = UseSelected;
+  }
+
+  // only a few algorithms are able to ignore case
+  if (ignoreCase)
+  {
+    switch (algorithm)
+    {
+    case UseNative:
+    case UseAVX2:
+      algorithm = UseAVX2NoCase;
+      break;
+    case UseSWAR:
+      algorithm = UseSWARNoCase;
+      break;
+    case UseBoyerMooreHorspool:
+      algorithm = UseBoyerMooreHorspoolNoCase;
+      break;
+    case UseBitap:
+      algorithm = UseBitapNoCase;
+      break;
+    case UseUtf8:
+    case UseBitapPattern:
+    case UseRegex:
+    case UseIndex:
+      break;
+    default:
+      printf("-i is only supported by --native, --swar, --avx2, --boyermoorehorspool and --bitap\n");
+      free(data);
+      return -2;
+    }
+  }
+
+  // rank bytes by their frequency in the first 64k of the file
+  unsigned char frequency[256];
+  if (algorithm == UseNativeRareByte)
+    trainByteFrequency(frequency, haystack, haystackLength < 65536 ? haystackLength : 65536);
+
+  // UTF-8 case folding (always case-insensitive)
+  Utf8Pattern* utf8Pattern = NULL;
+  if (algorithm == UseUtf8)
+  {
+    utf8Pattern = compileUtf8Pattern(needle, needleLength);
+    if (!utf8Pattern)
+    {
+      printf("Out of memory\n");
+      return -5;
+    }
+  }
+
+  // ? [abc] [a-z] [^...] and case folding, at most 64 bytes long
+  BitapPattern* bitapPattern = NULL;
+  if (algorithm == UseBitapPattern)
+  {
+    bitapPattern = compileBitapPattern(needle, needleLength, ignoreCase);
+    if (!bitapPattern)
+    {
+      printf("Invalid pattern\n");
+      return -2;
+    }
+  }
+
+  // . [] \d \w \s * + ? ^ $ (no alternation)
+  Regex* regex = NULL;
+  if (algorithm == UseRegex)
+  {
+    regex = compileRegex(needle, needleLength, ignoreCase);
+    if (!regex)
+    {
+      printf("Invalid regular expression\n");
+      return -2;
+    }
+  }
+
   // search until done ...
   unsigned int numHits = 0;
+  // line number of the most recent hit and where that line begins
+  size_t      lineNumber  = 1;
+  const char* lineCounted = haystack;
   const char* current = haystack;
+  // non-zero if current points to the end of the line of the previous hit
+  int afterHit = 0;
   for (;;)
   {
     // offset of current hit from the beginning of the haystack
     size_t bytesDone = current - haystack;
     size_t bytesLeft = haystackLength - bytesDone;
 
+    // Bloom filters: jump to the next blocks which may contain needle
+    size_t rangeEnd  = haystackLength;
+    if (blockQuery)
+    {
+      size_t rangeStart;
+      if (!nextBlockRange(blockQuery, bytesDone, &rangeStart, &rangeEnd))
+        break;
+      current   = haystack + rangeStart;
+      bytesDone = rangeStart;
+      bytesLeft = rangeEnd - rangeStart;
+    }
+
     switch (algorithm)
     {
     case UseMemMem:
@@ -165,6 +423,10 @@ int main(int argc, char* argv[])
         }
       }
       break;
+    case UseSelected:
+      // chosen by selectSearchFunction()
+      current = selected                (current, bytesLeft, needle, needleLength);
+      break;
     case UseStrStr:
       // much faster but has problems when bytes in haystack are zero,
       // requires both to be properly zero-terminated
@@ -179,6 +441,39 @@ int main(int argc, char* argv[])
       // brute-force for short needles, based on compiler-optimized functions
       current = searchNative            (current, bytesLeft, needle, needleLength);
       break;
+    case UseNativeRareByte:
+      // same as before, but look for needle's rarest byte instead of its first byte
+      current = searchNativeRareByteTable(current, bytesLeft, needle, needleLength, frequency);
+      break;
+    case UseSWAR:
+      // first and last byte, 8 positions at once in a 64 bit register
+      current = searchSWAR              (current, bytesLeft, needle, needleLength);
+      break;
+    case UseSWARNoCase:
+      // same, but letters are ORed with 0x20
+      current = searchSWARNoCase        (current, bytesLeft, needle, needleLength);
+      break;
+    case UseAVX2NoCase:
+      current = searchAVX2NoCase        (current, bytesLeft, needle, needleLength);
+      break;
+    case UseBoyerMooreHorspoolNoCase:
+      current = searchBoyerMooreHorspoolNoCase(current, bytesLeft, needle, needleLength);
+      break;
+    case UseBitapNoCase:
+      current = searchBitapNoCase       (current, bytesLeft, needle, needleLength);
+      break;
+    case UseSSE42:
+      // SSE4.2 string instructions
+      current = searchSSE42             (current, bytesLeft, needle, needleLength);
+      break;
+    case UseAVX2:
+      // SIMD filter for first and last byte
+      current = searchAVX2              (current, bytesLeft, needle, needleLength);
+      break;
+    case UseAVX512:
+      // same with twice as many bytes per iteration
+      current = searchAVX512            (current, bytesLeft, needle, needleLength);
+      break;
     case UseKnuthMorrisPratt:
       // Knuth-Morris-Pratt
       current = searchKnuthMorrisPratt  (current, bytesLeft, needle, needleLength);
@@ -187,6 +482,20 @@ int main(int argc, char* argv[])
       // Boyer-Moore-Horspool
       current = searchBoyerMooreHorspool(current, bytesLeft, needle, needleLength);
       break;
+    case UseBoyerMoore:
+      // Boyer-Moore with good-suffix rule
+      current = searchBoyerMoore        (current, bytesLeft, needle, needleLength);
+      break;
+    case UseHash3:
+      // Boyer-Moore-Horspool with hashed q-grams, good for small alphabets
+      current = searchHash3             (current, bytesLeft, needle, needleLength);
+      break;
+    case UseHash5:
+      current = searchHash5             (current, bytesLeft, needle, needleLength);
+      break;
+    case UseHash8:
+      current = searchHash8             (current, bytesLeft, needle, needleLength);
+      break;
     case UseBitap:
       // Bitap / Baeza-Yates-Gonnet algorithm
       current = searchBitap             (current, bytesLeft, needle, needleLength);
@@ -195,6 +504,34 @@ int main(int argc, char* argv[])
       // Rabin-Karp algorithm
       current = searchRabinKarp         (current, bytesLeft, needle, needleLength);
       break;
+    case UseRabinKarp64:
+      // Rabin-Karp algorithm with a better hash
+      current = searchRabinKarp64       (current, bytesLeft, needle, needleLength);
+      break;
+    case UseUtf8:
+      // all case variants of needle, haystack isn't decoded
+      current = searchUtf8Pattern       (utf8Pattern, current, bytesLeft, NULL);
+      break;
+    case UseBitapPattern:
+      // Bitap with several allowed bytes per position
+      current = searchBitapPattern      (bitapPattern, current, bytesLeft, NULL);
+      break;
+    case UseRegex:
+      // regular expressions work line by line, start with the line after the previous hit
+      if (afterHit && bytesLeft > 0 && *current == '\n')
+      {
+        current++;
+        bytesLeft--;
+      }
+      // only lines containing the regex's longest literal are verified
+      current = searchRegex             (regex, current, bytesLeft, NULL);
+      break;
+    case UseIndex:
+      // skip matches in lines already printed
+      while (nextIndexMatch < numIndexMatches && indexMatches[nextIndexMatch] < bytesDone)
+        nextIndexMatch++;
+      current = nextIndexMatch < numIndexMatches ? haystack + indexMatches[nextIndexMatch] : NULL;
+      break;
 
     default:
       printf("Unknown search algorithm\n");
@@ -203,7 +540,16 @@ int main(int argc, char* argv[])
 
     // needle not found in the remaining haystack
     if (!current)
+    {
+      // continue with the block following the current range
+      if (blockQuery && rangeEnd < haystackLength)
+      {
+        current  = haystack + rangeEnd - (needleLength > 0 ? needleLength - 1 : 0);
+        afterHit = 0;
+        continue;
+      }
       break;
+    }
 
     numHits++;
 
@@ -214,16 +560,24 @@ int main(int argc, char* argv[])
 
     if (display == ShowCountOnly)
     {
-      current = right;
+      current  = right;
+      afterHit = 1;
       continue;
     }
 
     // find beginning of line
+    // (a hit may be an empty line, i.e. current points to its newline)
     const char* left = current;
-    while (left != haystack && *left != '\n')
+    while (left != haystack && left[-1] != '\n')
       left--;
-    if (*left == '\n' && left != haystackEnd)
-      left++;
+
+    // count lines since previous hit
+    if (showLineNumbers)
+    {
+      lineNumber += countNewlines(lineCounted, left - lineCounted);
+      lineCounted = left;
+      printf("%lu:", (unsigned long)lineNumber);
+    }
 
     // send line to standard output
     size_t lineLength = right - left;
@@ -232,12 +586,21 @@ int main(int argc, char* argv[])
     putchar('\n');
 
     // don't search this line anymore
-    current = right;
+    current  = right;
+    afterHit = 1;
   }
 
   if (display == ShowCountOnly)
     printf("%d\n", numHits);
 
+  freeUtf8Pattern(utf8Pattern);
+  freeBitapPattern(bitapPattern);
+  freeRegex(regex);
+  free(indexMatches);
+  closeIndex(index);
+  freeBlockQuery(blockQuery);
+  closeBlockFilter(filter);
+
   // exit with error code 1 if nothing found
   return numHits == 0 ? 1 : 0;
 }
@@ -0,0 +1,100 @@
+// //////////////////////////////////////////////////////////
+// myindex.c
+// Copyright (c) 2014,2019 Stephan Brumme. All rights reserved.
+// see http://create.stephan-brumme.com/disclaimer.html
+//
+
+// gcc -O3 -std=c99 -Wall -pedantic -pthread suffixarray.c fmindex.c blockfilter.c myindex.c -o myindex
+// builds a suffix array index for ./mygrep searchphrase filename --index indexfile
+// the file is processed in segments, only a few of them are in memory at the same time
+// --fm stores a compressed FM-index instead of a suffix array (about 1.3 instead of 4 bytes per byte of the file)
+// --bloom creates a small Bloom filter per block for ./mygrep searchphrase filename --bloom filterfile (append-only files are updated incrementally)
+
+#include "suffixarray.h"
+#include "blockfilter.h"
+
+#include <string.h> // strcmp()
+#include <stdio.h>  // printf()
+#include <stdlib.h> // atoi()
+
+
+int main(int argc, char* argv[])
+{
+  const char* syntax = "Syntax: ./myindex filename indexfile [--segment megabytes] [--maxneedle bytes] [--threads N] [--fm] [--sample N] [--bloom] [--block kilobytes]\n";
+  if (argc < 3)
+  {
+    printf("%s", syntax);
+    return -1;
+  }
+
+  // each thread needs about 6 * (segment size + maxNeedle) bytes
+  size_t       segmentSize = 256;
+  size_t       maxNeedle   = 256;
+  unsigned int numThreads  = 0; // number of CPU cores
+  // FM-index: locating a match takes at most sampleRate steps, each sampled position costs 4 bytes
+  int          fmIndex     = 0;
+  unsigned int sampleRate  = 32;
+  // Bloom filters: 1/64 of each block's size
+  int          bloom       = 0;
+  size_t       blockSize   = 64;
+
+  int i;
+  for (i = 3; i < argc; i++)
+  {
+    if      (strcmp(argv[i], "--segment")   == 0 && i + 1 < argc)
+      segmentSize = atoi(argv[++i]);
+    else if (strcmp(argv[i], "--maxneedle") == 0 && i + 1 < argc)
+      maxNeedle   = atoi(argv[++i]);
+    else if (strcmp(argv[i], "--threads")   == 0 && i + 1 < argc)
+      numThreads  = atoi(argv[++i]);
+    else if (strcmp(argv[i], "--fm")        == 0)
+      fmIndex     = 1;
+    else if (strcmp(argv[i], "--sample")    == 0 && i + 1 < argc)
+      sampleRate  = atoi(argv[++i]);
+    else if (strcmp(argv[i], "--bloom")     == 0)
+      bloom       = 1;
+    else if (strcmp(argv[i], "--block")     == 0 && i + 1 < argc)
+      blockSize   = atoi(argv[++i]);
+    else
+    {
+      printf("%s", syntax);
+      return -2;
+    }
+  }
+
+  // suffix arrays have 32 bit entries
+  if (segmentSize == 0 || segmentSize > 2048 || maxNeedle == 0 || maxNeedle > (1 << 20))
+  {
+    printf("Segments must be between 1 and 2048 MB, needles between 1 byte and 1 MB\n");
+    return -2;
+  }
+  if (fmIndex && (sampleRate == 0 || sampleRate > 65536))
+  {
+    printf("Sample rate must be between 1 and 65536\n");
+    return -2;
+  }
+  if (bloom && (blockSize == 0 || blockSize > (1 << 20)))
+  {
+    printf("Blocks must be between 1 KB and 1 GB\n");
+    return -2;
+  }
+
+  // only the filter, no suffix array
+  if (bloom)
+  {
+    if (!buildBlockFilter(argv[1], argv[2], blockSize << 10, maxNeedle))
+    {
+      printf("Failed to build filter\n");
+      return -3;
+    }
+    return 0;
+  }
+
+  if (!buildIndex(argv[1], argv[2], segmentSize << 20, maxNeedle, numThreads, fmIndex ? sampleRate : 0))
+  {
+    printf("Failed to build index\n");
+    return -3;
+  }
+
+  return 0;
+}
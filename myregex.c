@@ -0,0 +1,491 @@
+// //////////////////////////////////////////////////////////
+// myregex.c
+// Copyright (c) 2014,2019 Stephan Brumme. All rights reserved.
+// see http://create.stephan-brumme.com/disclaimer.html
+//
+
+// compiles with: gcc -Wall -std=c99 (requires search.c)
+
+#include "myregex.h"
+#include "search.h"
+
+#include <string.h> // memset
+#include <stdlib.h> // malloc / free
+
+
+/// what a single element of a regular expression matches
+enum RegexNodeType
+{
+  /// a byte from a set (literals and . are sets, too)
+  MatchSet,
+  /// ^
+  MatchLineStart,
+  /// $
+  MatchLineEnd
+};
+
+/// how often an element may be repeated
+enum RegexQuantifier
+{
+  ExactlyOnce,
+  ZeroOrOne,  // ?
+  ZeroOrMore, // *
+  OneOrMore   // +
+};
+
+/// a single element of a regular expression
+typedef struct
+{
+  unsigned char type;
+  unsigned char quantifier;
+  /// non-zero if byte is allowed
+  unsigned char allowed[256];
+  /// the byte if allowed[] describes a single literal (ignoring case), else -1
+  int           literal;
+} RegexNode;
+
+/// compiled regular expression
+struct Regex
+{
+  size_t     numNodes;
+  RegexNode* nodes;
+  /// longest literal each match contains
+  char*      literal;
+  size_t     literalLength;
+  int        ignoreCase;
+};
+
+
+/// release memory of a compiled regular expression
+void freeRegex(Regex* regex)
+{
+  if (!regex)
+    return;
+
+  free(regex->nodes);
+  free(regex->literal);
+  free(regex);
+}
+
+
+/// add upper and lower case of each allowed letter
+static void foldSet(unsigned char allowed[256])
+{
+  unsigned int c;
+  for (c = 'a'; c <= 'z'; c++)
+    allowed[c] = allowed[c & ~0x20] = allowed[c] | allowed[c & ~0x20];
+}
+
+
+/// \d \w \s, returns 0 if escaped byte isn't a class
+static int escapedClass(unsigned char escaped, unsigned char allowed[256])
+{
+  unsigned int c;
+  switch (escaped)
+  {
+  case 'd':
+    for (c = '0'; c <= '9'; c++)
+      allowed[c] = 1;
+    return 1;
+  case 'w':
+    for (c = 0; c < 256; c++)
+      if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_')
+        allowed[c] = 1;
+    return 1;
+  case 's':
+    allowed[' ' ] = allowed['\t'] = allowed['\r'] = allowed['\f'] = allowed['\v'] = 1;
+    return 1;
+  default:
+    return 0;
+  }
+}
+
+
+/// compile a regular expression, returns NULL if invalid or out of memory
+Regex* compileRegex(const char* pattern, size_t patternLength, int ignoreCase)
+{
+  // detect invalid input
+  if (!pattern)
+    return NULL;
+
+  Regex* regex = (Regex*)calloc(1, sizeof(Regex));
+  if (!regex)
+    return NULL;
+  regex->ignoreCase = ignoreCase;
+
+  // each byte of the pattern creates at most one node
+  regex->nodes   = (RegexNode*)malloc((patternLength + 1) * sizeof(RegexNode));
+  regex->literal = (char*)     malloc( patternLength + 1);
+  if (!regex->nodes || !regex->literal)
+  {
+    freeRegex(regex);
+    return NULL;
+  }
+
+  size_t i = 0;
+  while (i < patternLength)
+  {
+    unsigned char current = (unsigned char)pattern[i++];
+
+    // repeat previous element
+    if (current == '*' || current == '+' || current == '?')
+    {
+      // nothing to repeat or already repeated
+      if (regex->numNodes == 0)
+      {
+        freeRegex(regex);
+        return NULL;
+      }
+      RegexNode* previous = &regex->nodes[regex->numNodes - 1];
+      if (previous->type != MatchSet || previous->quantifier != ExactlyOnce)
+      {
+        freeRegex(regex);
+        return NULL;
+      }
+      previous->quantifier = current == '*' ? ZeroOrMore : current == '+' ? OneOrMore : ZeroOrOne;
+      continue;
+    }
+
+    RegexNode* node = &regex->nodes[regex->numNodes++];
+    memset(node, 0, sizeof(RegexNode));
+    node->type       = MatchSet;
+    node->quantifier = ExactlyOnce;
+    node->literal    = -1;
+
+    if (current == '^')
+    {
+      node->type = MatchLineStart;
+      continue;
+    }
+    if (current == '$')
+    {
+      node->type = MatchLineEnd;
+      continue;
+    }
+
+    if (current == '.')
+    {
+      // anything but a newline
+      memset(node->allowed, 1, sizeof(node->allowed));
+      node->allowed['\n'] = 0;
+      continue;
+    }
+
+    if (current == '[')
+    {
+      int negate = i < patternLength && pattern[i] == '^';
+      if (negate)
+        i++;
+
+      // a closing bracket right at the beginning is a literal
+      int first = 1;
+      while (i < patternLength && (pattern[i] != ']' || first))
+      {
+        first = 0;
+        unsigned char from = (unsigned char)pattern[i++];
+        if (from == '\\' && i < patternLength)
+        {
+          from = (unsigned char)pattern[i++];
+          if (escapedClass(from, node->allowed))
+            continue;
+        }
+
+        // range
+        unsigned char to = from;
+        if (i + 1 < patternLength && pattern[i] == '-' && pattern[i + 1] != ']')
+        {
+          i++;
+          to = (unsigned char)pattern[i++];
+          if (to == '\\' && i < patternLength)
+            to = (unsigned char)pattern[i++];
+        }
+
+        unsigned int c;
+        for (c = from; c <= to; c++)
+          node->allowed[c] = 1;
+      }
+
+      // missing closing bracket
+      if (i == patternLength)
+      {
+        freeRegex(regex);
+        return NULL;
+      }
+      i++;
+
+      if (ignoreCase)
+        foldSet(node->allowed);
+      if (negate)
+      {
+        unsigned int c;
+        for (c = 0; c < 256; c++)
+          node->allowed[c] = !node->allowed[c];
+        // sets never match a newline
+        node->allowed['\n'] = 0;
+      }
+      continue;
+    }
+
+    if (current == '\\')
+    {
+      // pattern must not end with a backslash
+      if (i == patternLength)
+      {
+        freeRegex(regex);
+        return NULL;
+      }
+      current = (unsigned char)pattern[i++];
+      if (escapedClass(current, node->allowed))
+        continue;
+    }
+
+    // literal
+    node->allowed[current] = 1;
+    node->literal          = current;
+    if (ignoreCase)
+    {
+      foldSet(node->allowed);
+      if (current >= 'A' && current <= 'Z')
+        node->literal = current | 0x20;
+    }
+  }
+
+  // find the longest run of literals each match must contain:
+  // "x" and "x+" are mandatory, "x+" ends a run but its last x starts a new one, "x*" and "x?" end a run
+  size_t runLength = 0;
+  size_t node;
+  for (node = 0; node <= regex->numNodes; node++)
+  {
+    const RegexNode* current = node < regex->numNodes ? &regex->nodes[node] : NULL;
+    // anchors don't consume anything
+    if (current && current->type != MatchSet)
+      continue;
+
+    int mandatory = current && current->literal >= 0 &&
+                    (current->quantifier == ExactlyOnce || current->quantifier == OneOrMore);
+    if (mandatory && current->quantifier == ExactlyOnce)
+    {
+      runLength++;
+      continue;
+    }
+    // x+ is the last element of the current run
+    if (mandatory)
+      runLength++;
+
+    // end of a run
+    if (runLength > regex->literalLength)
+    {
+      regex->literalLength = runLength;
+      // collect bytes backwards, skipping anchors
+      size_t scan  = node + (mandatory ? 1 : 0);
+      size_t write = runLength;
+      while (write > 0)
+      {
+        scan--;
+        if (regex->nodes[scan].type == MatchSet)
+          regex->literal[--write] = (char)regex->nodes[scan].literal;
+      }
+    }
+
+    // x+ starts a new run
+    runLength = mandatory ? 1 : 0;
+  }
+
+  return regex;
+}
+
+
+/// the literal used as a prefilter (may be empty)
+const char* regexLiteral(const Regex* regex, size_t* literalLength)
+{
+  if (!regex)
+    return NULL;
+
+  if (literalLength)
+    *literalLength = regex->literalLength;
+  return regex->literal;
+}
+
+
+/// marks a state without a running match
+static const size_t Inactive = (size_t)-1;
+
+/// state i means "nodes [0, i) matched", starts[i] is the earliest position where such a match began (or Inactive),
+/// follow all transitions which don't consume a byte: optional elements and anchors (they only lead to the next state)
+static void followEmpty(const Regex* regex, size_t* starts, size_t pos, size_t lineBegin, size_t lineEnd)
+{
+  size_t i;
+  for (i = 0; i < regex->numNodes; i++)
+  {
+    if (starts[i] == Inactive)
+      continue;
+
+    const RegexNode* current = &regex->nodes[i];
+    int skip;
+    switch (current->type)
+    {
+    case MatchLineStart:
+      skip = pos == lineBegin;
+      break;
+    case MatchLineEnd:
+      skip = pos == lineEnd;
+      break;
+    default:
+      skip = current->quantifier == ZeroOrOne || current->quantifier == ZeroOrMore;
+      break;
+    }
+
+    // an earlier start wins (leftmost match)
+    if (skip && starts[i] < starts[i + 1])
+      starts[i + 1] = starts[i];
+  }
+}
+
+
+/// leftmost match inside a line (longest at that position), returns -1 if out of memory
+/** all elements are simulated at once (like a Thompson NFA), so each byte is processed only once per element:
+    O(line length * number of elements) without any backtracking **/
+static int matchLine(const Regex* regex, const unsigned char* text, size_t lineBegin, size_t lineEnd,
+                     size_t* matchBegin, size_t* matchEnd)
+{
+  const size_t numStates = regex->numNodes + 1;
+
+  // try to use stack instead of heap (avoid slow memory allocations if possible)
+  const size_t MaxLocalMemory = 64;
+  size_t localMemory[2 * MaxLocalMemory];
+  size_t* memory = localMemory;
+  // stack too small => allocate heap
+  if (numStates > MaxLocalMemory)
+  {
+    memory = (size_t*)malloc(2 * numStates * sizeof(size_t));
+    if (memory == NULL)
+      return -1;
+  }
+  // states before and after the current byte
+  size_t* starts = memory;
+  size_t* next   = memory + numStates;
+
+  size_t i;
+  for (i = 0; i < numStates; i++)
+    starts[i] = Inactive;
+
+  int    found     = 0;
+  size_t bestBegin = 0;
+  size_t bestEnd   = 0;
+
+  size_t pos;
+  for (pos = lineBegin; ; pos++)
+  {
+    // a new match may begin here (unless an earlier one was already found)
+    if (!found && starts[0] == Inactive)
+      starts[0] = pos;
+    followEmpty(regex, starts, pos, lineBegin, lineEnd);
+
+    // all nodes matched ? keep the leftmost, then the longest
+    size_t begin = starts[regex->numNodes];
+    if (begin != Inactive && (!found || begin <= bestBegin))
+    {
+      found     = 1;
+      bestBegin = begin;
+      bestEnd   = pos;
+    }
+
+    if (pos == lineEnd)
+      break;
+
+    // consume the next byte
+    int active = 0;
+    for (i = 0; i < numStates; i++)
+      next[i] = Inactive;
+    for (i = 0; i < regex->numNodes; i++)
+    {
+      // matches beginning after the best one can't win anymore
+      if (starts[i] == Inactive || (found && starts[i] > bestBegin))
+        continue;
+
+      const RegexNode* current = &regex->nodes[i];
+      if (current->type != MatchSet || !current->allowed[text[pos]])
+        continue;
+
+      // repeat the same element
+      if ((current->quantifier == ZeroOrMore || current->quantifier == OneOrMore) && starts[i] < next[i])
+        next[i] = starts[i];
+      // or continue with the next element
+      if (starts[i] < next[i + 1])
+        next[i + 1] = starts[i];
+      active = 1;
+    }
+
+    // swap
+    size_t* swap = starts;
+    starts = next;
+    next   = swap;
+
+    // nothing left to extend
+    if (found && !active)
+      break;
+  }
+
+  if (memory != localMemory)
+    free(memory);
+
+  *matchBegin = bestBegin;
+  *matchEnd   = bestEnd;
+  return found;
+}
+
+
+/// find the leftmost match, stores its length in matchLength (if not NULL), returns NULL if none (or out of memory)
+const char* searchRegex(const Regex* regex, const char* haystack, size_t haystackLength, size_t* matchLength)
+{
+  // detect invalid input
+  if (!regex || !haystack)
+    return NULL;
+
+  const unsigned char* text = (const unsigned char*)haystack;
+  size_t matchBegin, matchEnd;
+
+  size_t pos = 0;
+  while (pos <= haystackLength)
+  {
+    // there is no line after the final newline (and none in an empty haystack)
+    if (pos == haystackLength && (pos == 0 || text[pos - 1] == '\n'))
+      break;
+
+    // jump to the next line containing the literal
+    if (regex->literalLength > 0)
+    {
+      const char* candidate = regex->ignoreCase ?
+          searchAVX2NoCase(haystack + pos, haystackLength - pos, regex->literal, regex->literalLength) :
+          searchAVX2      (haystack + pos, haystackLength - pos, regex->literal, regex->literalLength);
+      if (!candidate)
+        return NULL;
+
+      // go back to the beginning of the line
+      size_t found = candidate - haystack;
+      while (found > pos && text[found - 1] != '\n')
+        found--;
+      pos = found;
+    }
+
+    // find end of line
+    const char* newline = (const char*)memchr(haystack + pos, '\n', haystackLength - pos);
+    size_t lineEnd = newline ? (size_t)(newline - haystack) : haystackLength;
+
+    int matched = matchLine(regex, text, pos, lineEnd, &matchBegin, &matchEnd);
+    if (matched < 0)
+      return NULL;
+    if (matched)
+    {
+      if (matchLength)
+        *matchLength = matchEnd - matchBegin;
+      return haystack + matchBegin;
+    }
+
+    // next line
+    pos = lineEnd + 1;
+  }
+
+  // no match
+  return NULL;
+}
@@ -0,0 +1,32 @@
+// //////////////////////////////////////////////////////////
+// myregex.h
+// Copyright (c) 2014,2019 Stephan Brumme. All rights reserved.
+// see http://create.stephan-brumme.com/disclaimer.html
+//
+
+#pragma once
+
+#include <stddef.h> // size_t
+
+// simple regular expressions, matched line by line:
+// .      any byte except newline
+// [abc]  set of bytes, ranges such as [a-z] and negated sets [^...] are allowed
+// \d \w \s digits, word characters, whitespace
+// \x     any other escaped byte is a literal
+// * + ?  repeat the previous element (the longest match is reported, like POSIX)
+// ^ $    beginning / end of a line
+// no alternation, no groups
+
+/// compiled regular expression
+typedef struct Regex Regex;
+
+/// compile a regular expression, returns NULL if invalid or out of memory
+Regex*      compileRegex(const char* pattern, size_t patternLength, int ignoreCase);
+/// release memory of a compiled regular expression
+void        freeRegex   (Regex* regex);
+/// find the leftmost match, stores its length in matchLength (if not NULL), returns NULL if none (or out of memory)
+/** the longest literal every match must contain is located with a fast search.h kernel,
+    only the lines where it was found are verified, all elements at once (no backtracking, linear in the line's length) **/
+const char* searchRegex (const Regex* regex, const char* haystack, size_t haystackLength, size_t* matchLength);
+/// the literal used as a prefilter (may be empty)
+const char* regexLiteral(const Regex* regex, size_t* literalLength);
@@ -13,6 +13,34 @@
 
 #include <string.h> // strlen
 #include <stdlib.h> // malloc / free
+#include <stdint.h> // uint64_t
+#include <stdio.h>  // fopen (calibration profiles)
+
+// SIMD kernels need GCC/Clang's function attributes to enable instruction sets per function,
+// the CPU is checked at runtime => no special compiler flags required
+// (define SEARCH_NO_SIMD for toolchains that can't handle intrinsics, e.g. when compiling with -mno-sse)
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) && !defined(SEARCH_NO_SIMD)
+#define SEARCH_X86_SIMD
+#include <immintrin.h>
+#endif
+
+
+/// ASCII only: convert upper case letters to lower case, everything else is unchanged (no locale involved)
+static unsigned char foldCase(unsigned char c)
+{
+  return (c >= 'A' && c <= 'Z') ? c | 0x20 : c;
+}
+
+
+/// compare two memory blocks, ignoring ASCII case
+static int equalNoCase(const char* a, const char* b, size_t length)
+{
+  size_t i;
+  for (i = 0; i < length; i++)
+    if (foldCase((unsigned char)a[i]) != foldCase((unsigned char)b[i]))
+      return 0;
+  return 1;
+}
 
 
 /// naive approach (for C strings)
@@ -101,10 +129,10 @@ const char* searchKnuthMorrisPrattString(const char* haystack, const char* needl
   const size_t MaxLocalMemory = 256;
   int localMemory[MaxLocalMemory];
   int* skip = localMemory;
-  // stack too small => allocate heap
-  if (needleLength > MaxLocalMemory)
+  // stack too small => allocate heap (one more entry than needle's length)
+  if (needleLength + 1 > MaxLocalMemory)
   {
-    skip = (int*)malloc(needleLength * sizeof(int));
+    skip = (int*)malloc((needleLength + 1) * sizeof(int));
     if (skip == NULL)
       return NULL;
   }
@@ -166,10 +194,10 @@ const char* searchKnuthMorrisPratt(const char* haystack, size_t haystackLength,
   const size_t MaxLocalMemory = 256;
   int localMemory[MaxLocalMemory];
   int* skip = localMemory;
-  // stack too small => allocate heap
-  if (needleLength > MaxLocalMemory)
+  // stack too small => allocate heap (one more entry than needle's length)
+  if (needleLength + 1 > MaxLocalMemory)
   {
-    skip = (int*)malloc(needleLength * sizeof(int));
+    skip = (int*)malloc((needleLength + 1) * sizeof(int));
     if (skip == NULL)
       return NULL;
   }
@@ -219,6 +247,26 @@ const char* searchKnuthMorrisPratt(const char* haystack, size_t haystackLength,
 // //////////////////////////////////////////////////////////
 
 
+/// skip table of Boyer-Moore-Horspool and its relatives: distance of each byte's right-most occurrence
+/// in the first numPositions bytes of needle to position numPositions
+static void createSkipTable(size_t skip[256], const char* needle, size_t numPositions)
+{
+  // default value: when a character in haystack isn't in needle, then
+  //                we can jump forward numPositions + 1 bytes
+  const size_t NumChar = 1 << (8 * sizeof(char));
+  size_t i;
+  for (i = 0; i < NumChar; i++)
+    skip[i] = numPositions + 1;
+
+  // figure out for each character of the needle how much we can skip
+  // (if a character appears multiple times in needle, later occurrences
+  //  overwrite previous ones, i.e. the value of skip[x] decreases)
+  size_t pos;
+  for (pos = 0; pos < numPositions; pos++)
+    skip[(unsigned char)needle[pos]] = numPositions - pos;
+}
+
+
 /// Boyer-Moore-Horspool algorithm (for C strings)
 const char* searchBoyerMooreHorspoolString(const char* haystack, const char* needle)
 {
@@ -245,24 +293,13 @@ const char* searchBoyerMooreHorspool(const char* haystack, size_t haystackLength
 
   // find right-most position of each character
   // and store its distance to the end of needle
-
-  // default value: when a character in haystack isn't in needle, then
-  //                we can jump forward needleLength bytes
   const size_t NumChar = 1 << (8 * sizeof(char));
   size_t skip[NumChar];
-  size_t i;
-  for (i = 0; i < NumChar; i++)
-    skip[i] = needleLength;
-
-  // figure out for each character of the needle how much we can skip
-  // (if a character appears multiple times in needle, later occurrences
-  //  overwrite previous ones, i.e. the value of skip[x] decreases)
   const size_t lastPos = needleLength - 1;
-  size_t pos;
-  for (pos = 0; pos < lastPos; pos++)
-    skip[(unsigned char)needle[pos]] = lastPos - pos;
+  createSkipTable(skip, needle, lastPos);
 
   // now walk through the haystack
+  size_t i;
   while (haystackLength >= needleLength)
   {
     // all characters match ?
@@ -281,52 +318,48 @@ const char* searchBoyerMooreHorspool(const char* haystack, size_t haystackLength
 }
 
 
-// //////////////////////////////////////////////////////////
-
-
-/// Bitap algorithm / Baeza-Yates-Gonnet algorithm (for C strings)
-const char* searchBitapString(const char* haystack, const char* needle)
+/// Boyer-Moore-Horspool algorithm, ignoring ASCII case
+/** skip distance of upper and lower case letter is the shorter one of both **/
+const char* searchBoyerMooreHorspoolNoCase(const char* haystack, size_t haystackLength,
+                                           const char* needle,   size_t needleLength)
 {
   // detect invalid input
-  if (!haystack || !needle)
+  if (!haystack || !needle || haystackLength < needleLength)
     return NULL;
 
   // empty needle matches everything
-  size_t needleLength = strlen(needle);
   if (needleLength == 0)
     return haystack;
 
-  // create bit masks for each possible byte / ASCII character
-  // each mask is as wide as needleLength
-  const size_t MaxBitWidth = 8 * sizeof(int) - 1;
-  // only if needleLength bits fit into an integer (minus 1), the algorithm will be fast
-  if (needleLength > MaxBitWidth)
-    return searchSimpleString(haystack, needle);
-
-  // one mask per allowed character (1 byte => 2^8 => 256)
-  // where all bits are set except those where the character is found in needle
-  const size_t AlphabetSize = 256;
-  unsigned int masks[AlphabetSize];
-  size_t i;
-  for (i = 0; i < AlphabetSize; i++)
-    masks[i] = ~0;
-  for (i = 0; i < needleLength; i++)
-    masks[(unsigned char)needle[i]] &= ~(1 << i);
+  const size_t NumChar = 1 << (8 * sizeof(char));
+  size_t skip[NumChar];
+  const size_t lastPos = needleLength - 1;
+  createSkipTable(skip, needle, lastPos);
 
-  // initial state mask has all bits set except the lowest one
-  unsigned int state = ~1;
-  const unsigned int FullMatch = 1 << needleLength;
-  while (*haystack)
+  // merge upper and lower case
+  unsigned char c;
+  for (c = 'a'; c <= 'z'; c++)
   {
-    // update the bit array
-    state  |= masks[(unsigned char)*haystack];
-    state <<= 1;
+    unsigned char upper = c & ~0x20;
+    if (skip[upper] < skip[c])
+      skip[c]     = skip[upper];
+    else
+      skip[upper] = skip[c];
+  }
 
-    // if an unset bit "bubbled up" we have a match
-    if ((state & FullMatch) == 0)
-      return (haystack - needleLength) + 1;
+  // now walk through the haystack
+  size_t i;
+  while (haystackLength >= needleLength)
+  {
+    // all characters match ?
+    for (i = lastPos; foldCase((unsigned char)haystack[i]) == foldCase((unsigned char)needle[i]); i--)
+      if (i == 0)
+        return haystack;
 
-    haystack++;
+    // no match, jump ahead
+    unsigned char marker = (unsigned char) haystack[lastPos];
+    haystackLength -= skip[marker];
+    haystack       += skip[marker];
   }
 
   // needle not found in haystack
@@ -334,9 +367,22 @@ const char* searchBitapString(const char* haystack, const char* needle)
 }
 
 
-/// Bitap algorithm / Baeza-Yates-Gonnet algorithm (for C strings)
-const char* searchBitap(const char* haystack, size_t haystackLength,
-                        const char* needle,   size_t needleLength)
+/// Quick Search algorithm by Daniel M. Sunday (for C strings)
+const char* searchQuickSearchString(const char* haystack, const char* needle)
+{
+  // detect invalid input
+  if (!haystack || !needle)
+    return NULL;
+
+  // call routine for non-text data
+  return searchQuickSearch(haystack, strlen(haystack), needle, strlen(needle));
+}
+
+
+/// Quick Search algorithm by Daniel M. Sunday (for non-text data)
+/** same as Boyer-Moore-Horspool but skip depends on the byte following the current window **/
+const char* searchQuickSearch(const char* haystack, size_t haystackLength,
+                              const char* needle,   size_t needleLength)
 {
   // detect invalid input
   if (!haystack || !needle || haystackLength < needleLength)
@@ -346,40 +392,30 @@ const char* searchBitap(const char* haystack, size_t haystackLength,
   if (needleLength == 0)
     return haystack;
 
-  // create bit masks for each possible byte / ASCII character
-  // each mask is as wide as needleLength
-  const size_t MaxBitWidth  = 8 * sizeof(int) - 1;
-  // only if needleLength bits fit into an integer (minus 1), the algorithm will be fast
-  if (needleLength > MaxBitWidth)
-    return searchNative(haystack, haystackLength, needle, needleLength);
-
-  // one mask per allowed character (1 byte => 2^8 => 256)
-  // where all bits are set except those where the character is found in needle
-  const size_t AlphabetSize = 256;
-  unsigned int masks[AlphabetSize];
-  size_t i;
-  for (i = 0; i < AlphabetSize; i++)
-    masks[i] = ~0;
-  for (i = 0; i < needleLength; i++)
-    masks[(unsigned char)needle[i]] &= ~(1 << i);
-
-  // points beyond last considered byte
-  const char* haystackEnd = haystack + haystackLength;
+  // distance of each character's right-most position to the byte behind needle
+  const size_t NumChar = 1 << (8 * sizeof(char));
+  size_t skip[NumChar];
+  createSkipTable(skip, needle, needleLength);
 
-  // initial state mask has all bits set except the lowest one
-  unsigned int state = ~1;
-  const unsigned int FullMatch = 1 << needleLength;
-  while (haystack != haystackEnd)
+  // now walk through the haystack
+  for (;;)
   {
-    // update the bit array
-    state  |= masks[(unsigned char)*haystack];
-    state <<= 1;
+    // all characters match ?
+    if (memcmp(haystack, needle, needleLength) == 0)
+      return haystack;
 
-    // if an unset bit "bubbled up" we have a match
-    if ((state & FullMatch) == 0)
-      return (haystack - needleLength) + 1;
+    // no byte behind the current window
+    if (haystackLength == needleLength)
+      break;
 
-    haystack++;
+    // no match, jump ahead
+    unsigned char marker = (unsigned char) haystack[needleLength];
+    haystackLength -= skip[marker];
+    haystack       += skip[marker];
+
+    // not enough haystack left ?
+    if (haystackLength < needleLength)
+      break;
   }
 
   // needle not found in haystack
@@ -387,63 +423,55 @@ const char* searchBitap(const char* haystack, size_t haystackLength,
 }
 
 
-// //////////////////////////////////////////////////////////
-
-
-/// Rabin-Karp algorithm
-/** based on simple hash proposed by Raphael Javaux **/
-const char* searchRabinKarpString(const char* haystack, const char* needle)
+/// Raita algorithm (for C strings)
+const char* searchRaitaString(const char* haystack, const char* needle)
 {
   // detect invalid input
   if (!haystack || !needle)
     return NULL;
 
-  // empty needle matches everything
-  if (!*needle)
-    return haystack;
+  // call routine for non-text data
+  return searchRaita(haystack, strlen(haystack), needle, strlen(needle));
+}
 
-  // find first match of the first letter
-  haystack = strchr(haystack, *needle);
-  if (!haystack)
+
+/// Raita algorithm (for non-text data)
+/** same as Boyer-Moore-Horspool but compares last, first and middle byte before the remaining bytes **/
+const char* searchRaita(const char* haystack, size_t haystackLength,
+                        const char* needle,   size_t needleLength)
+{
+  // detect invalid input
+  if (!haystack || !needle || haystackLength < needleLength)
     return NULL;
 
-  // now first letter of haystack and needle is identical
-  // let's compute the sum of all characters of needle
-  unsigned int hashNeedle   = *needle;
-  unsigned int hashHaystack = *haystack;
-  const char*  scanNeedle   = needle   + 1;
-  const char*  scanHaystack = haystack + 1;
-  while (*scanNeedle && *scanHaystack)
-  {
-    hashNeedle   += *scanNeedle++;
-    hashHaystack += *scanHaystack++;
-  }
+  // empty needle matches everything
+  if (needleLength == 0)
+    return haystack;
 
-  // if scanNeedle doesn't point to zero, then we have too little haystack
-  if (*scanNeedle)
-    return NULL;
+  // same skip table as Boyer-Moore-Horspool
+  const size_t NumChar = 1 << (8 * sizeof(char));
+  size_t skip[NumChar];
+  const size_t lastPos = needleLength - 1;
+  createSkipTable(skip, needle, lastPos);
 
-  // length of needle
-  const size_t needleLength = scanNeedle - needle;
+  // bytes checked first
+  const size_t middlePos = needleLength / 2;
+  const char   first     = needle[0];
+  const char   middle    = needle[middlePos];
+  const char   last      = needle[lastPos];
 
-  // walk through haystack and roll the hash
-  for (;;)
+  // now walk through the haystack
+  while (haystackLength >= needleLength)
   {
-    // identical hash ?
-    if (hashHaystack == hashNeedle)
-    {
-      // can be a false positive, therefore must check all characters again
-      if (memcmp(haystack, needle, needleLength) == 0)
-        return haystack;
-    }
-
-    // no more bytes left ?
-    if (!*scanHaystack)
-      break;
+    // last, first and middle byte match ? then compare all bytes in between (not worth skipping the middle byte)
+    char marker = haystack[lastPos];
+    if (marker == last && haystack[0] == first && haystack[middlePos] == middle &&
+        (needleLength <= 2 || memcmp(haystack + 1, needle + 1, needleLength - 2) == 0))
+      return haystack;
 
-    // update hash
-    hashHaystack -= *haystack++;
-    hashHaystack += *scanHaystack++;
+    // no match, jump ahead
+    haystackLength -= skip[(unsigned char)marker];
+    haystack       += skip[(unsigned char)marker];
   }
 
   // needle not found in haystack
@@ -451,10 +479,21 @@ const char* searchRabinKarpString(const char* haystack, const char* needle)
 }
 
 
-/// Rabin-Karp algorithm
-/** based on simple hash proposed by Raphael Javaux **/
-const char* searchRabinKarp(const char* haystack, size_t haystackLength,
-                            const char* needle,   size_t needleLength)
+/// hash of q bytes for searchHashQ, result has 12 bits
+static size_t hashQGram(const char* data, size_t q, size_t shift)
+{
+  size_t hash = 0;
+  size_t i;
+  for (i = 0; i < q; i++)
+    hash = (hash << shift) + (unsigned char)data[i];
+  return hash & 4095;
+}
+
+/// Boyer-Moore-Horspool with a skip table indexed by the hash of the last q bytes of the current window
+/** based on Thierry Lecroq's HASHq algorithm, works well on small alphabets (like DNA) where single bytes barely skip **/
+static const char* searchHashQ(const char* haystack, size_t haystackLength,
+                               const char* needle,   size_t needleLength,
+                               size_t q)
 {
   // detect invalid input
   if (!haystack || !needle || haystackLength < needleLength)
@@ -464,43 +503,60 @@ const char* searchRabinKarp(const char* haystack, size_t haystackLength,
   if (needleLength == 0)
     return haystack;
 
-  // one byte beyond last position where a match can begin
-  const char* haystackEnd = haystack + haystackLength - needleLength + 1;
-
-  // find first match of the first letter
-  haystack = (const char*)memchr(haystack, *needle, haystackLength);
-  if (!haystack)
-    return NULL;
-
-  // now first letter of haystack and needle is identical
-  // let's compute the sum of all characters of needle
-  unsigned int hashNeedle   = 0;
-  unsigned int hashHaystack = 0;
+  // needle too short: fall back to Boyer-Moore-Horspool
+  if (needleLength < q)
+    return searchBoyerMooreHorspool(haystack, haystackLength, needle, needleLength);
+
+  // 12 bit hash => 4096 entries, each q-gram shifts the hash by 12/q bits
+  const size_t HashSize  = 4096;
+  const size_t HashShift = q >= 8 ? 1 : 12 / q;
+
+  // shifts are stored as 16 bit integers to keep the table small (8k),
+  // for huge needles the shifts are capped (smaller shifts are always safe)
+  const size_t MaxShift = 65535;
+  unsigned short skip[HashSize];
+  size_t defaultShift = needleLength - q + 1;
+  if (defaultShift > MaxShift)
+    defaultShift = MaxShift;
   size_t i;
-  for (i = 0; i < needleLength; i++)
-  {
-    // not enough haystack left ?
-    if (!haystack[i])
-      return NULL;
+  for (i = 0; i < HashSize; i++)
+    skip[i] = (unsigned short)defaultShift;
 
-    hashNeedle   += needle  [i];
-    hashHaystack += haystack[i];
+  // distance of each q-gram's right-most occurrence to the end of needle (except the last q-gram)
+  const size_t lastPos = needleLength - 1;
+  for (i = q - 1; i < lastPos; i++)
+  {
+    size_t shift = lastPos - i;
+    if (shift > MaxShift)
+      continue;
+    skip[hashQGram(needle + i + 1 - q, q, HashShift)] = (unsigned short)shift;
   }
 
-  // walk through haystack and roll the hash computation
-  while (haystack != haystackEnd)
+  // last q-gram: zero marks a potential match, afterwards shift by its previous value
+  size_t lastHash  = hashQGram(needle + needleLength - q, q, HashShift);
+  size_t matchSkip = skip[lastHash];
+  if (matchSkip == 0)
+    matchSkip = 1;
+  skip[lastHash] = 0;
+
+  // now walk through the haystack
+  while (haystackLength >= needleLength)
   {
-    // identical hash ?
-    if (hashHaystack == hashNeedle)
+    size_t shift = skip[hashQGram(haystack + needleLength - q, q, HashShift)];
+
+    // last q bytes may match ? then compare all bytes
+    if (shift == 0)
     {
-      // can be a false positive, therefore must check all characters again
       if (memcmp(haystack, needle, needleLength) == 0)
         return haystack;
+      shift = matchSkip;
     }
 
-    // update hash
-    hashHaystack += *(haystack + needleLength);
-    hashHaystack -= *haystack++;
+    // jump ahead
+    if (haystackLength < needleLength + shift)
+      break;
+    haystackLength -= shift;
+    haystack       += shift;
   }
 
   // needle not found in haystack
@@ -508,50 +564,2767 @@ const char* searchRabinKarp(const char* haystack, size_t haystackLength,
 }
 
 
-// //////////////////////////////////////////////////////////
+/// Boyer-Moore-Horspool with a skip table indexed by 3-grams (for non-text data, small alphabets)
+const char* searchHash3(const char* haystack, size_t haystackLength,
+                        const char* needle,   size_t needleLength)
+{
+  return searchHashQ(haystack, haystackLength, needle, needleLength, 3);
+}
 
 
-/// super-fast for short strings (less than about 8 bytes), else use searchSimple or searchBoyerMooreHorspool
-const char* searchNative(const char* haystack, size_t haystackLength,
-                         const char* needle,   size_t needleLength)
+/// Boyer-Moore-Horspool with a skip table indexed by 5-grams (for non-text data, small alphabets)
+const char* searchHash5(const char* haystack, size_t haystackLength,
+                        const char* needle,   size_t needleLength)
 {
-  // uses memchr() for the first byte, then memcmp to verify it's a valid match
+  return searchHashQ(haystack, haystackLength, needle, needleLength, 5);
+}
 
-  // detect invalid input
-  if (!haystack || !needle || haystackLength < needleLength)
-    return NULL;
 
-  // empty needle matches everything
+/// Boyer-Moore-Horspool with a skip table indexed by 8-grams (for non-text data, small alphabets and long needles)
+const char* searchHash8(const char* haystack, size_t haystackLength,
+                        const char* needle,   size_t needleLength)
+{
+  return searchHashQ(haystack, haystackLength, needle, needleLength, 8);
+}
+
+
+// //////////////////////////////////////////////////////////
+
+
+/// Boyer-Moore algorithm (for C strings)
+const char* searchBoyerMooreString(const char* haystack, const char* needle)
+{
+  // detect invalid input
+  if (!haystack || !needle)
+    return NULL;
+
+  // call routine for non-text data
+  return searchBoyerMoore(haystack, strlen(haystack), needle, strlen(needle));
+}
+
+
+/// Boyer-Moore algorithm with bad-character and good-suffix rule and Galil's optimization (for non-text data)
+const char* searchBoyerMoore(const char* haystack, size_t haystackLength,
+                             const char* needle,   size_t needleLength)
+{
+  // detect invalid input
+  if (!haystack || !needle || haystackLength < needleLength)
+    return NULL;
+
+  // empty needle matches everything
   if (needleLength == 0)
     return haystack;
 
-  // shorter code for just one character
-  if (needleLength == 1)
-    return (const char*)memchr(haystack, *needle, haystackLength);
+  // bad-character rule: same table as Boyer-Moore-Horspool
+  const size_t NumChar = 1 << (8 * sizeof(char));
+  size_t skip[NumChar];
+  const int lastPos = (int)needleLength - 1;
+  createSkipTable(skip, needle, lastPos);
+
+  // try to use stack instead of heap (avoid slow memory allocations if possible)
+  const size_t MaxLocalMemory = 256;
+  int localMemory[2 * MaxLocalMemory];
+  int* suffix = localMemory;
+  // stack too small => allocate heap
+  if (needleLength > MaxLocalMemory)
+  {
+    suffix = (int*)malloc(2 * needleLength * sizeof(int));
+    if (suffix == NULL)
+      return NULL;
+  }
+  int* goodSuffix = suffix + needleLength;
+
+  // suffix[i] = length of the longest substring ending at i which is a suffix of needle, too
+  int i;
+  int f = 0;
+  int g = lastPos;
+  suffix[lastPos] = needleLength;
+  for (i = lastPos - 1; i >= 0; i--)
+  {
+    if (i > g && suffix[i + lastPos - f] < i - g)
+      suffix[i] = suffix[i + lastPos - f];
+    else
+    {
+      if (i < g)
+        g = i;
+      f = i;
+      while (g >= 0 && needle[g] == needle[g + lastPos - f])
+        g--;
+      suffix[i] = f - g;
+    }
+  }
+
+  // good-suffix rule: mismatch at position i => shift goodSuffix[i] bytes
+  // default: jump beyond the matched suffix
+  for (i = 0; i <= lastPos; i++)
+    goodSuffix[i] = needleLength;
+  // matched suffix contains a prefix of needle
+  int j = 0;
+  for (i = lastPos; i >= 0; i--)
+    if (suffix[i] == i + 1)
+      for (; j < lastPos - i; j++)
+        if (goodSuffix[j] == (int)needleLength)
+          goodSuffix[j] = lastPos - i;
+  // matched suffix appears somewhere else in needle
+  for (i = 0; i < lastPos; i++)
+    goodSuffix[lastPos - suffix[i]] = lastPos - i;
+
+  // assume no match
+  const char* result = NULL;
+  // Galil's rule: the first "known" bytes of needle are known to match the current haystack position
+  int known = 0;
+  while (haystackLength >= needleLength)
+  {
+    // compare from right to left, stop early if remaining bytes are known to match
+    for (i = lastPos; i >= known && haystack[i] == needle[i]; i--)
+      ;
+
+    // all characters match ?
+    if (i < known)
+    {
+      result = haystack;
+      break;
+    }
+
+    // no match, jump ahead by whatever rule allows the larger shift
+    int shift   = goodSuffix[i];
+    int badChar = (int)skip[(unsigned char)haystack[i]] - (lastPos - i);
+    known = 0;
+    if (badChar > shift)
+      shift = badChar;
+    // matched part of haystack (right of i) is a prefix of the next alignment ?
+    else if (shift > i)
+      known = needleLength - shift;
+
+    haystackLength -= shift;
+    haystack       += shift;
+  }
+
+  // clean up heap (if used)
+  if (suffix != localMemory)
+    free(suffix);
+
+  // points to match position or NULL if not found
+  return result;
+}
+
+
+// //////////////////////////////////////////////////////////
+
+
+/// Bitap algorithm / Baeza-Yates-Gonnet algorithm (for C strings)
+const char* searchBitapString(const char* haystack, const char* needle)
+{
+  // detect invalid input
+  if (!haystack || !needle)
+    return NULL;
+
+  // empty needle matches everything
+  size_t needleLength = strlen(needle);
+  if (needleLength == 0)
+    return haystack;
+
+  // create bit masks for each possible byte / ASCII character
+  // each mask is as wide as needleLength
+  const size_t MaxBitWidth = 8 * sizeof(int) - 1;
+  // only if needleLength bits fit into an integer (minus 1), the algorithm will be fast
+  if (needleLength > MaxBitWidth)
+    return searchSimpleString(haystack, needle);
+
+  // one mask per allowed character (1 byte => 2^8 => 256)
+  // where all bits are set except those where the character is found in needle
+  const size_t AlphabetSize = 256;
+  unsigned int masks[AlphabetSize];
+  size_t i;
+  for (i = 0; i < AlphabetSize; i++)
+    masks[i] = ~0;
+  for (i = 0; i < needleLength; i++)
+    masks[(unsigned char)needle[i]] &= ~(1 << i);
+
+  // initial state mask has all bits set except the lowest one
+  unsigned int state = ~1;
+  const unsigned int FullMatch = 1 << needleLength;
+  while (*haystack)
+  {
+    // update the bit array
+    state  |= masks[(unsigned char)*haystack];
+    state <<= 1;
+
+    // if an unset bit "bubbled up" we have a match
+    if ((state & FullMatch) == 0)
+      return (haystack - needleLength) + 1;
+
+    haystack++;
+  }
+
+  // needle not found in haystack
+  return NULL;
+}
+
+
+/// bit masks of bit-parallel algorithms: bit (i % 64) of masks[c * numWords + i / 64] is set if needle[i] == c
+static void createBitMasks(uint64_t* masks, size_t numWords, const char* needle, size_t needleLength)
+{
+  // one mask per allowed character (1 byte => 2^8 => 256), each consisting of numWords words
+  const size_t AlphabetSize = 256;
+  size_t i;
+  for (i = 0; i < AlphabetSize * numWords; i++)
+    masks[i] = 0;
+  for (i = 0; i < needleLength; i++)
+    masks[(unsigned char)needle[i] * numWords + i / 64] |= (uint64_t)1 << (i % 64);
+}
+
+
+/// Bitap algorithm / Baeza-Yates-Gonnet algorithm (for non-text data)
+const char* searchBitap(const char* haystack, size_t haystackLength,
+                        const char* needle,   size_t needleLength)
+{
+  // detect invalid input
+  if (!haystack || !needle || haystackLength < needleLength)
+    return NULL;
+
+  // empty needle matches everything
+  if (needleLength == 0)
+    return haystack;
+
+  // create bit masks for each possible byte / ASCII character
+  // each mask is as wide as needleLength
+  const size_t MaxBitWidth  = 64;
+  // only if needleLength bits fit into a 64 bit integer, the algorithm will be fast
+  if (needleLength > MaxBitWidth)
+    return searchNative(haystack, haystackLength, needle, needleLength);
+
+  // one mask per allowed character (1 byte => 2^8 => 256)
+  // where only those bits are set where the character is found in needle
+  const size_t AlphabetSize = 256;
+  uint64_t masks[AlphabetSize];
+  createBitMasks(masks, 1, needle, needleLength);
 
-  haystackLength -= needleLength - 1;
   // points beyond last considered byte
   const char* haystackEnd = haystack + haystackLength;
 
-  // look for first byte
-  while ((haystack = (const char*)memchr(haystack, *needle, haystackLength)) != NULL)
+  // bit i of state is set if the last i+1 bytes match the first i+1 bytes of needle ("Shift-And")
+  uint64_t state = 0;
+  const uint64_t FullMatch = (uint64_t)1 << (needleLength - 1);
+  while (haystack != haystackEnd)
   {
-    // does last byte match, too ?
-    if (haystack[needleLength - 1] == needle[needleLength - 1])
-      // okay, perform full comparison, skip first and last byte (if just 2 bytes => already finished)
-      if (needleLength == 2 || memcmp(haystack + 1, needle + 1, needleLength - 2) == 0)
-        return haystack;
+    // update the bit array
+    state   = (state << 1) | 1;
+    state  &= masks[(unsigned char)*haystack];
 
-    // compute number of remaining bytes
-    haystackLength = haystackEnd - haystack;
-    if (haystackLength == 0)
+    // if a set bit "bubbled up" we have a match
+    if (state & FullMatch)
+      return (haystack - needleLength) + 1;
+
+    haystack++;
+  }
+
+  // needle not found in haystack
+  return NULL;
+}
+
+
+/// Bitap algorithm, ignoring ASCII case
+/** upper and lower case letters share the same bit mask **/
+const char* searchBitapNoCase(const char* haystack, size_t haystackLength,
+                              const char* needle,   size_t needleLength)
+{
+  // detect invalid input
+  if (!haystack || !needle || haystackLength < needleLength)
+    return NULL;
+
+  // empty needle matches everything
+  if (needleLength == 0)
+    return haystack;
+
+  // long needle: same as searchBitap
+  const size_t MaxBitWidth = 64;
+  if (needleLength > MaxBitWidth)
+    return searchSWARNoCase(haystack, haystackLength, needle, needleLength);
+
+  const size_t AlphabetSize = 256;
+  uint64_t masks[AlphabetSize];
+  createBitMasks(masks, 1, needle, needleLength);
+
+  // merge upper and lower case
+  unsigned char c;
+  for (c = 'a'; c <= 'z'; c++)
+  {
+    unsigned char upper = c & ~0x20;
+    masks[c] = masks[upper] = masks[c] | masks[upper];
+  }
+
+  // points beyond last considered byte
+  const char* haystackEnd = haystack + haystackLength;
+
+  // same as searchBitap
+  uint64_t state = 0;
+  const uint64_t FullMatch = (uint64_t)1 << (needleLength - 1);
+  while (haystack != haystackEnd)
+  {
+    state   = (state << 1) | 1;
+    state  &= masks[(unsigned char)*haystack];
+
+    if (state & FullMatch)
+      return (haystack - needleLength) + 1;
+
+    haystack++;
+  }
+
+  // needle not found in haystack
+  return NULL;
+}
+
+
+/// a Bitap needle where each position may allow several bytes
+struct BitapPattern
+{
+  /// one bit per position, set if the byte is allowed at that position
+  uint64_t masks[256];
+  /// number of positions (at most 64)
+  size_t   length;
+  /// first position allows a single byte only: jump with memchr() while there is no partial match
+  int      firstByte;
+};
+
+
+/// compile a pattern for searchBitapPattern, returns NULL if invalid, longer than 64 positions or out of memory
+/** syntax: ? matches any byte, [abc] a set of bytes, [a-z] a range, [^...] everything else,
+    \ turns the next byte into a literal, (?i) and (?-i) enable / disable case folding for the following positions **/
+BitapPattern* compileBitapPattern(const char* pattern, size_t patternLength, int ignoreCase)
+{
+  // detect invalid input
+  if (!pattern)
+    return NULL;
+
+  BitapPattern* result = (BitapPattern*)calloc(1, sizeof(BitapPattern));
+  if (!result)
+    return NULL;
+
+  const size_t MaxBitWidth  = 64;
+  const size_t AlphabetSize = 256;
+  unsigned char allowed[AlphabetSize];
+  int    foldCase  = ignoreCase;
+  size_t numFirst  = 0;
+
+  size_t i = 0;
+  while (i < patternLength)
+  {
+    // switch case folding
+    if (patternLength - i >= 4 && memcmp(pattern + i, "(?i)",  4) == 0)
+    {
+      foldCase = 1;
+      i += 4;
+      continue;
+    }
+    if (patternLength - i >= 5 && memcmp(pattern + i, "(?-i)", 5) == 0)
+    {
+      foldCase = 0;
+      i += 5;
+      continue;
+    }
+
+    // too long for a single 64 bit integer
+    if (result->length == MaxBitWidth)
+    {
+      freeBitapPattern(result);
       return NULL;
+    }
+
+    memset(allowed, 0, sizeof(allowed));
+    int negate = 0;
+    unsigned char current = (unsigned char)pattern[i++];
+    if (current == '?')
+    {
+      // any byte
+      memset(allowed, 1, sizeof(allowed));
+    }
+    else if (current == '[')
+    {
+      negate = i < patternLength && pattern[i] == '^';
+      if (negate)
+        i++;
+
+      // a closing bracket right at the beginning is a literal
+      int first = 1;
+      while (i < patternLength && (pattern[i] != ']' || first))
+      {
+        first = 0;
+        unsigned char from = (unsigned char)pattern[i++];
+        if (from == '\\' && i < patternLength)
+          from = (unsigned char)pattern[i++];
+
+        // range
+        unsigned char to = from;
+        if (i + 1 < patternLength && pattern[i] == '-' && pattern[i + 1] != ']')
+        {
+          i++;
+          to = (unsigned char)pattern[i++];
+          if (to == '\\' && i < patternLength)
+            to = (unsigned char)pattern[i++];
+        }
+
+        unsigned int c;
+        for (c = from; c <= to; c++)
+          allowed[c] = 1;
+      }
+
+      // missing closing bracket
+      if (i == patternLength)
+      {
+        freeBitapPattern(result);
+        return NULL;
+      }
+      i++;
+    }
+    else
+    {
+      // escaped byte
+      if (current == '\\')
+      {
+        if (i == patternLength)
+        {
+          freeBitapPattern(result);
+          return NULL;
+        }
+        current = (unsigned char)pattern[i++];
+      }
+      allowed[current] = 1;
+    }
+
+    // add the other case of letters (before negating a set)
+    unsigned int c;
+    if (foldCase)
+      for (c = 'a'; c <= 'z'; c++)
+        allowed[c] = allowed[c & ~0x20] = allowed[c] | allowed[c & ~0x20];
+
+    uint64_t bit = (uint64_t)1 << result->length;
+    size_t numAllowed = 0;
+    for (c = 0; c < AlphabetSize; c++)
+      if (allowed[c] != negate)
+      {
+        result->masks[c] |= bit;
+        numAllowed++;
+        if (result->length == 0)
+          result->firstByte = (int)c;
+      }
+
+    if (result->length == 0)
+      numFirst = numAllowed;
+    result->length++;
+  }
+
+  // more than one byte allowed at the first position
+  if (numFirst != 1)
+    result->firstByte = -1;
+
+  return result;
+}
+
+
+/// release memory of a compiled Bitap pattern
+void freeBitapPattern(BitapPattern* pattern)
+{
+  free(pattern);
+}
+
+
+/// Bitap algorithm with wildcards and sets of bytes, stores length of the match in matchLength (if not NULL)
+const char* searchBitapPattern(const BitapPattern* pattern,
+                               const char* haystack, size_t haystackLength, size_t* matchLength)
+{
+  // detect invalid input
+  if (!pattern || !haystack || haystackLength < pattern->length)
+    return NULL;
+
+  if (matchLength)
+    *matchLength = pattern->length;
+
+  // empty needle matches everything
+  if (pattern->length == 0)
+    return haystack;
+
+  // points beyond last considered byte
+  const char* haystackEnd = haystack + haystackLength;
+
+  // same as searchBitap
+  uint64_t state = 0;
+  const uint64_t FullMatch = (uint64_t)1 << (pattern->length - 1);
+  while (haystack != haystackEnd)
+  {
+    // no partial match: skip to the next possible beginning of a match
+    if (state == 0 && pattern->firstByte >= 0)
+    {
+      haystack = (const char*)memchr(haystack, pattern->firstByte, haystackEnd - haystack);
+      if (!haystack)
+        return NULL;
+    }
+
+    state   = (state << 1) | 1;
+    state  &= pattern->masks[(unsigned char)*haystack];
+
+    if (state & FullMatch)
+      return (haystack - pattern->length) + 1;
 
-    // keep going
     haystack++;
-    haystackLength--;
   }
 
   // needle not found in haystack
   return NULL;
 }
+
+
+// //////////////////////////////////////////////////////////
+
+
+/// Backward Nondeterministic DAWG Matching (for C strings)
+const char* searchBackwardNondeterministicDawgString(const char* haystack, const char* needle)
+{
+  // detect invalid input
+  if (!haystack || !needle)
+    return NULL;
+
+  // call routine for non-text data
+  return searchBackwardNondeterministicDawg(haystack, strlen(haystack), needle, strlen(needle));
+}
+
+
+/// Backward Nondeterministic DAWG Matching (for non-text data)
+/** reads each window from right to left, bit-parallel simulation of an automaton recognizing all factors of needle,
+    uses multiple 64 bit words per state if needle is longer than 64 bytes **/
+const char* searchBackwardNondeterministicDawg(const char* haystack, size_t haystackLength,
+                                               const char* needle,   size_t needleLength)
+{
+  // detect invalid input
+  if (!haystack || !needle || haystackLength < needleLength)
+    return NULL;
+
+  // empty needle matches everything
+  if (needleLength == 0)
+    return haystack;
+
+  // same bit masks as Bitap
+  const size_t AlphabetSize = 256;
+  const size_t numWords     = (needleLength + 63) / 64;
+
+  // short needle: state fits into a single 64 bit integer
+  if (numWords == 1)
+  {
+    uint64_t masks[AlphabetSize];
+    createBitMasks(masks, 1, needle, needleLength);
+
+    while (haystackLength >= needleLength)
+    {
+      // bit i of state is set if the bytes read so far match needle at position i
+      uint64_t state = ~(uint64_t)0;
+      size_t   pos   = needleLength;
+      // right-most position where a prefix of needle starts
+      size_t   last  = needleLength;
+      do
+      {
+        state &= masks[(unsigned char)haystack[--pos]];
+        // bytes read so far are a prefix of needle ?
+        if (state & 1)
+        {
+          // read the whole window => match
+          if (pos == 0)
+            return haystack;
+          last = pos;
+        }
+        state >>= 1;
+      } while (state != 0);
+
+      // no match, jump ahead to the right-most prefix of needle
+      haystackLength -= last;
+      haystack       += last;
+    }
+
+    // needle not found in haystack
+    return NULL;
+  }
+
+  // long needle: masks and state consist of several 64 bit words
+  uint64_t* masks = (uint64_t*)malloc((AlphabetSize + 1) * numWords * sizeof(uint64_t));
+  if (!masks)
+    return NULL;
+  createBitMasks(masks, numWords, needle, needleLength);
+  uint64_t* state = masks + AlphabetSize * numWords;
+
+  // assume no match
+  const char* result = NULL;
+  while (haystackLength >= needleLength)
+  {
+    size_t word;
+    for (word = 0; word < numWords; word++)
+      state[word] = ~(uint64_t)0;
+
+    size_t pos  = needleLength;
+    size_t last = needleLength;
+    uint64_t any;
+    do
+    {
+      const uint64_t* mask = masks + (unsigned char)haystack[--pos] * numWords;
+      for (word = 0; word < numWords; word++)
+        state[word] &= mask[word];
+
+      if (state[0] & 1)
+      {
+        if (pos == 0)
+        {
+          result = haystack;
+          break;
+        }
+        last = pos;
+      }
+
+      // shift all words by one bit and check whether any bit is still set
+      any = 0;
+      for (word = 0; word + 1 < numWords; word++)
+      {
+        state[word] = (state[word] >> 1) | (state[word + 1] << 63);
+        any |= state[word];
+      }
+      state[numWords - 1] >>= 1;
+      any |= state[numWords - 1];
+    } while (any != 0);
+
+    if (result)
+      break;
+
+    // no match, jump ahead to the right-most prefix of needle
+    haystackLength -= last;
+    haystack       += last;
+  }
+
+  free(masks);
+  return result;
+}
+
+
+/// Backward Oracle Matching (for C strings)
+const char* searchBackwardOracleMatchingString(const char* haystack, const char* needle)
+{
+  // detect invalid input
+  if (!haystack || !needle)
+    return NULL;
+
+  // call routine for non-text data
+  return searchBackwardOracleMatching(haystack, strlen(haystack), needle, strlen(needle));
+}
+
+
+/// Backward Oracle Matching (for non-text data)
+/** reads each window from right to left, factor oracle of the reversed needle decides when to stop,
+    works best for very long needles **/
+const char* searchBackwardOracleMatching(const char* haystack, size_t haystackLength,
+                                         const char* needle,   size_t needleLength)
+{
+  // detect invalid input
+  if (!haystack || !needle || haystackLength < needleLength)
+    return NULL;
+
+  // empty needle matches everything
+  if (needleLength == 0)
+    return haystack;
+
+  // factor oracle of the reversed needle: state i has a transition to i+1 for needle[lastPos - i]
+  // plus a few "external" transitions (at most needleLength in total), stored as linked lists
+  // except for the initial state which has a transition for each distinct byte of needle => lookup table
+  // supply[i]    = supply function of state i
+  // firstEdge[i] = first external transition of state i (or -1)
+  // edges        = byte, target state and next edge of the same state
+  const int lastPos = (int)needleLength - 1;
+  int* memory = (int*)malloc((2 * (needleLength + 1) + 3 * needleLength) * sizeof(int));
+  if (!memory)
+    return NULL;
+  int* supply    = memory;
+  int* firstEdge = supply    + needleLength + 1;
+  int* edgeByte  = firstEdge + needleLength + 1;
+  int* edgeState = edgeByte  + needleLength;
+  int* edgeNext  = edgeState + needleLength;
+  int  numEdges  = 0;
+  const size_t AlphabetSize = 256;
+  int initial[AlphabetSize];
+
+  // build oracle
+  int i;
+  supply   [0] = -1;
+  firstEdge[0] = -1;
+  for (i = 1; i <= (int)needleLength; i++)
+  {
+    unsigned char current = (unsigned char)needle[lastPos - (i - 1)];
+    firstEdge[i] = -1;
+
+    // follow supply links and add external transitions until a state already has one for current byte
+    int state = supply[i - 1];
+    int target = -1;
+    while (state >= 0)
+    {
+      // internal transition ?
+      if (state < (int)needleLength && (unsigned char)needle[lastPos - state] == current)
+      {
+        target = state + 1;
+        break;
+      }
+      // external transition ?
+      int edge;
+      for (edge = firstEdge[state]; edge >= 0; edge = edgeNext[edge])
+        if (edgeByte[edge] == current)
+          break;
+      if (edge >= 0)
+      {
+        target = edgeState[edge];
+        break;
+      }
+
+      // add transition to new state
+      edgeByte [numEdges] = current;
+      edgeState[numEdges] = i;
+      edgeNext [numEdges] = firstEdge[state];
+      firstEdge[state]    = numEdges++;
+
+      state = supply[state];
+    }
+    supply[i] = target < 0 ? 0 : target;
+  }
+
+  // transitions of initial state
+  for (i = 0; i < (int)AlphabetSize; i++)
+    initial[i] = -1;
+  initial[(unsigned char)needle[lastPos]] = 1;
+  int edge;
+  for (edge = firstEdge[0]; edge >= 0; edge = edgeNext[edge])
+    initial[edgeByte[edge]] = edgeState[edge];
+
+  // assume no match
+  const char* result = NULL;
+  while (haystackLength >= needleLength)
+  {
+    // read window from right to left as long as the oracle knows the bytes
+    int pos   = (int)needleLength;
+    int state = initial[(unsigned char)haystack[pos - 1]];
+    if (state >= 0)
+      pos--;
+    while (state >= 0 && pos > 0)
+    {
+      unsigned char current = (unsigned char)haystack[pos - 1];
+      if (state < (int)needleLength && (unsigned char)needle[lastPos - state] == current)
+        state++;
+      else
+      {
+        for (edge = firstEdge[state]; edge >= 0; edge = edgeNext[edge])
+          if (edgeByte[edge] == current)
+            break;
+        if (edge < 0)
+          break;
+        state = edgeState[edge];
+      }
+      pos--;
+    }
+
+    // read the whole window (the only string of that length accepted by the oracle is needle itself)
+    if (pos == 0)
+    {
+      result = haystack;
+      break;
+    }
+
+    // no match, jump behind the unknown byte
+    haystackLength -= pos;
+    haystack       += pos;
+  }
+
+  free(memory);
+  return result;
+}
+
+
+// //////////////////////////////////////////////////////////
+
+
+/// Rabin-Karp algorithm
+/** based on simple hash proposed by Raphael Javaux **/
+const char* searchRabinKarpString(const char* haystack, const char* needle)
+{
+  // detect invalid input
+  if (!haystack || !needle)
+    return NULL;
+
+  // empty needle matches everything
+  if (!*needle)
+    return haystack;
+
+  // find first match of the first letter
+  haystack = strchr(haystack, *needle);
+  if (!haystack)
+    return NULL;
+
+  // now first letter of haystack and needle is identical
+  // let's compute the sum of all characters of needle
+  unsigned int hashNeedle   = *needle;
+  unsigned int hashHaystack = *haystack;
+  const char*  scanNeedle   = needle   + 1;
+  const char*  scanHaystack = haystack + 1;
+  while (*scanNeedle && *scanHaystack)
+  {
+    hashNeedle   += *scanNeedle++;
+    hashHaystack += *scanHaystack++;
+  }
+
+  // if scanNeedle doesn't point to zero, then we have too little haystack
+  if (*scanNeedle)
+    return NULL;
+
+  // length of needle
+  const size_t needleLength = scanNeedle - needle;
+
+  // walk through haystack and roll the hash
+  for (;;)
+  {
+    // identical hash ?
+    if (hashHaystack == hashNeedle)
+    {
+      // can be a false positive, therefore must check all characters again
+      if (memcmp(haystack, needle, needleLength) == 0)
+        return haystack;
+    }
+
+    // no more bytes left ?
+    if (!*scanHaystack)
+      break;
+
+    // update hash
+    hashHaystack -= *haystack++;
+    hashHaystack += *scanHaystack++;
+  }
+
+  // needle not found in haystack
+  return NULL;
+}
+
+
+/// Rabin-Karp algorithm
+/** based on simple hash proposed by Raphael Javaux **/
+const char* searchRabinKarp(const char* haystack, size_t haystackLength,
+                            const char* needle,   size_t needleLength)
+{
+  // detect invalid input
+  if (!haystack || !needle || haystackLength < needleLength)
+    return NULL;
+
+  // empty needle matches everything
+  if (needleLength == 0)
+    return haystack;
+
+  // one byte beyond last position where a match can begin
+  const char* haystackEnd = haystack + haystackLength - needleLength + 1;
+
+  // find first match of the first letter (where a match could still begin)
+  haystack = (const char*)memchr(haystack, *needle, haystackEnd - haystack);
+  if (!haystack)
+    return NULL;
+
+  // now first letter of haystack and needle is identical
+  // let's compute the sum of all characters of needle
+  unsigned int hashNeedle   = 0;
+  unsigned int hashHaystack = 0;
+  size_t i;
+  for (i = 0; i < needleLength; i++)
+  {
+    hashNeedle   += needle  [i];
+    hashHaystack += haystack[i];
+  }
+
+  // walk through haystack and roll the hash computation
+  while (haystack != haystackEnd)
+  {
+    // identical hash ?
+    if (hashHaystack == hashNeedle)
+    {
+      // can be a false positive, therefore must check all characters again
+      if (memcmp(haystack, needle, needleLength) == 0)
+        return haystack;
+    }
+
+    // reached last position ? don't read beyond the end of haystack
+    if (haystack + 1 == haystackEnd)
+      break;
+
+    // update hash
+    hashHaystack += *(haystack + needleLength);
+    hashHaystack -= *haystack++;
+  }
+
+  // needle not found in haystack
+  return NULL;
+}
+
+
+/// multiplier of the polynomial rolling hash (odd, large and with well-mixed bits)
+static const uint64_t RollingHashBase = 0x100000001B3ULL;
+
+/// polynomial hash of the first length bytes: data[0] * base^(length-1) + ... + data[length-1], modulo 2^64
+static uint64_t rollingHash(const char* data, size_t length)
+{
+  uint64_t hash = 0;
+  size_t i;
+  for (i = 0; i < length; i++)
+    hash = hash * RollingHashBase + (unsigned char)data[i];
+  return hash;
+}
+
+/// base^exponent modulo 2^64, needed to remove the oldest byte from a rolling hash
+static uint64_t rollingHashPower(size_t exponent)
+{
+  uint64_t result = 1;
+  uint64_t base   = RollingHashBase;
+  while (exponent > 0)
+  {
+    if (exponent & 1)
+      result *= base;
+    base     *= base;
+    exponent >>= 1;
+  }
+  return result;
+}
+
+
+/// Rabin-Karp algorithm with a 64-bit polynomial rolling hash (for C strings)
+const char* searchRabinKarp64String(const char* haystack, const char* needle)
+{
+  // detect invalid input
+  if (!haystack || !needle)
+    return NULL;
+
+  // call routine for non-text data
+  return searchRabinKarp64(haystack, strlen(haystack), needle, strlen(needle));
+}
+
+
+/// Rabin-Karp algorithm with a 64-bit polynomial rolling hash (for non-text data)
+/** unlike a plain sum, permutations of the needle produce different hashes, therefore memcmp is rarely called **/
+const char* searchRabinKarp64(const char* haystack, size_t haystackLength,
+                              const char* needle,   size_t needleLength)
+{
+  // detect invalid input
+  if (!haystack || !needle || haystackLength < needleLength)
+    return NULL;
+
+  // empty needle matches everything
+  if (needleLength == 0)
+    return haystack;
+
+  // last position where a match can begin
+  const char* haystackLast = haystack + haystackLength - needleLength;
+
+  // arithmetic is modulo 2^64 (unsigned overflow is well-defined)
+  const uint64_t hashNeedle   = rollingHash(needle,   needleLength);
+  uint64_t       hashHaystack = rollingHash(haystack, needleLength);
+  // weight of the byte leaving the window (after the window was shifted)
+  const uint64_t oldestFactor = rollingHashPower(needleLength);
+
+  for (;;)
+  {
+    // identical hash ? can still be a false positive, therefore must check all characters again
+    if (hashHaystack == hashNeedle && memcmp(haystack, needle, needleLength) == 0)
+      return haystack;
+
+    // reached end of haystack ?
+    if (haystack == haystackLast)
+      break;
+
+    // roll the hash: shift all bytes, remove oldest byte, add the next byte
+    // (only a single multiplication depends on the previous hash)
+    hashHaystack = hashHaystack * RollingHashBase
+                 - (unsigned char)haystack[0] * oldestFactor
+                 + (unsigned char)haystack[needleLength];
+    haystack++;
+  }
+
+  // needle not found in haystack
+  return NULL;
+}
+
+
+/// all needles of a RabinKarpSet with the same length
+typedef struct
+{
+  /// length of each needle
+  size_t    length;
+  /// base^length, removes the oldest byte from the rolling hash
+  uint64_t  oldestFactor;
+  /// number of needles
+  size_t    numNeedles;
+  /// all needles stored back-to-back (numNeedles * length bytes)
+  char*     bytes;
+  /// open addressing hash table: 0 => empty slot, else 1 + needle's position in bytes[]
+  uint32_t* slots;
+  size_t    slotBits;
+  /// blocked Bloom filter, about 16 bits per needle
+  uint64_t* filter;
+  /// log2 of the number of words
+  size_t    filterBits;
+} RabinKarpGroup;
+
+/// needles grouped by their length
+struct RabinKarpSet
+{
+  size_t          numGroups;
+  /// sorted by length (ascending)
+  RabinKarpGroup* groups;
+};
+
+
+/// blocked Bloom filter: a 64 bit word chosen by the hash's high bits (the low bits of a polynomial hash are weak),
+/// then three bits inside that word
+static uint64_t rabinKarpFilterBits(uint64_t hash)
+{
+  return ((uint64_t)1 << ((hash >> 20) & 63)) |
+         ((uint64_t)1 << ((hash >> 26) & 63)) |
+         ((uint64_t)1 << ((hash >> 32) & 63));
+}
+
+/// word of the blocked Bloom filter
+static size_t rabinKarpFilterIndex(const RabinKarpGroup* group, uint64_t hash)
+{
+  return (size_t)(hash >> (64 - group->filterBits));
+}
+
+/// first slot of the hash table (re-mixed, so that it's independent of the filter)
+static size_t rabinKarpSlotIndex(const RabinKarpGroup* group, uint64_t hash)
+{
+  return (size_t)((hash * 0x9E3779B97F4A7C15ULL) >> (64 - group->slotBits));
+}
+
+/// true if the Bloom filter can't rule out that a needle has this hash
+static int rabinKarpMaybe(const RabinKarpGroup* group, uint64_t hash)
+{
+  uint64_t bits = rabinKarpFilterBits(hash);
+  return (group->filter[rabinKarpFilterIndex(group, hash)] & bits) == bits;
+}
+
+/// find position of a needle in its group, returns NULL if not found
+static const char* rabinKarpLookup(const RabinKarpGroup* group, uint64_t hash, const char* data)
+{
+  // linear probing
+  size_t mask = ((size_t)1 << group->slotBits) - 1;
+  size_t slot = rabinKarpSlotIndex(group, hash);
+  while (group->slots[slot] != 0)
+  {
+    const char* candidate = group->bytes + (size_t)(group->slots[slot] - 1) * group->length;
+    if (memcmp(candidate, data, group->length) == 0)
+      return candidate;
+    slot = (slot + 1) & mask;
+  }
+
+  return NULL;
+}
+
+
+/// free all memory of a needle set
+void freeRabinKarpSet(RabinKarpSet* set)
+{
+  if (!set)
+    return;
+
+  size_t i;
+  for (i = 0; i < set->numGroups; i++)
+  {
+    free(set->groups[i].bytes);
+    free(set->groups[i].slots);
+    free(set->groups[i].filter);
+  }
+  free(set->groups);
+  free(set);
+}
+
+
+/// create a set of needles for searchRabinKarpSet, duplicates and empty needles are ignored, returns NULL if out of memory
+RabinKarpSet* createRabinKarpSet(const char* const* needles, const size_t* needleLengths, size_t numNeedles)
+{
+  // detect invalid input (32 bit slots)
+  if ((!needles || !needleLengths) && numNeedles > 0)
+    return NULL;
+  if (numNeedles >= 0xFFFFFFFFU)
+    return NULL;
+
+  RabinKarpSet* set = (RabinKarpSet*)calloc(1, sizeof(RabinKarpSet));
+  if (!set)
+    return NULL;
+
+  // collect distinct lengths
+  size_t i;
+  for (i = 0; i < numNeedles; i++)
+  {
+    size_t length = needleLengths[i];
+    if (length == 0)
+      continue;
+
+    // insert into list sorted by length
+    size_t g = 0;
+    while (g < set->numGroups && set->groups[g].length < length)
+      g++;
+    if (g < set->numGroups && set->groups[g].length == length)
+    {
+      set->groups[g].numNeedles++;
+      continue;
+    }
+
+    RabinKarpGroup* groups = (RabinKarpGroup*)realloc(set->groups, (set->numGroups + 1) * sizeof(RabinKarpGroup));
+    if (!groups)
+    {
+      freeRabinKarpSet(set);
+      return NULL;
+    }
+    set->groups = groups;
+    memmove(&groups[g + 1], &groups[g], (set->numGroups - g) * sizeof(RabinKarpGroup));
+    memset (&groups[g], 0, sizeof(RabinKarpGroup));
+    groups[g].length       = length;
+    groups[g].oldestFactor = rollingHashPower(length);
+    groups[g].numNeedles   = 1;
+    set->numGroups++;
+  }
+
+  // allocate memory: hash table is at most 75% full, filter has about 16 bits per needle
+  size_t g;
+  for (g = 0; g < set->numGroups; g++)
+  {
+    RabinKarpGroup* group = &set->groups[g];
+    group->slotBits = 1;
+    while (((size_t)3 << group->slotBits) < 4 * group->numNeedles)
+      group->slotBits++;
+    group->filterBits = 1;
+    while (((size_t)64 << group->filterBits) < 16 * group->numNeedles)
+      group->filterBits++;
+
+    group->bytes  = (char*)    malloc(group->numNeedles * group->length);
+    group->slots  = (uint32_t*)calloc((size_t)1 << group->slotBits, sizeof(uint32_t));
+    group->filter = (uint64_t*)calloc((size_t)1 << group->filterBits, sizeof(uint64_t));
+    if (!group->bytes || !group->slots || !group->filter)
+    {
+      freeRabinKarpSet(set);
+      return NULL;
+    }
+
+    // will be incremented while inserting (without duplicates)
+    group->numNeedles = 0;
+  }
+
+  // insert needles
+  for (i = 0; i < numNeedles; i++)
+  {
+    size_t length = needleLengths[i];
+    if (length == 0)
+      continue;
+
+    for (g = 0; set->groups[g].length != length; g++)
+      ;
+    RabinKarpGroup* group = &set->groups[g];
+
+    // skip duplicates
+    uint64_t hash = rollingHash(needles[i], length);
+    group->filter[rabinKarpFilterIndex(group, hash)] |= rabinKarpFilterBits(hash);
+    if (rabinKarpMaybe(group, hash) && rabinKarpLookup(group, hash, needles[i]))
+      continue;
+
+    // append needle
+    memcpy(group->bytes + group->numNeedles * length, needles[i], length);
+    group->numNeedles++;
+
+    // find empty slot
+    size_t mask = ((size_t)1 << group->slotBits) - 1;
+    size_t slot = rabinKarpSlotIndex(group, hash);
+    while (group->slots[slot] != 0)
+      slot = (slot + 1) & mask;
+    group->slots[slot] = (uint32_t)group->numNeedles;
+  }
+
+  return set;
+}
+
+
+/// Rabin-Karp algorithm for many needles at once (for non-text data)
+/** one rolling hash per needle length, stores length of the matching needle in matchLength (if not NULL) **/
+const char* searchRabinKarpSet(const RabinKarpSet* set,
+                               const char* haystack, size_t haystackLength, size_t* matchLength)
+{
+  // detect invalid input
+  if (!set || !haystack || set->numGroups == 0 || haystackLength < set->groups[0].length)
+    return NULL;
+
+  // all needles have the same length: keep the rolling hash in a register
+  if (set->numGroups == 1)
+  {
+    const RabinKarpGroup* group = &set->groups[0];
+    const char* haystackLast = haystack + haystackLength - group->length;
+    uint64_t hash = rollingHash(haystack, group->length);
+    for (;;)
+    {
+      // usually the filter already rejects
+      if (rabinKarpMaybe(group, hash) && rabinKarpLookup(group, hash, haystack))
+      {
+        if (matchLength)
+          *matchLength = group->length;
+        return haystack;
+      }
+
+      // reached end of haystack ?
+      if (haystack == haystackLast)
+        return NULL;
+
+      hash = hash * RollingHashBase
+           - (unsigned char)haystack[0] * group->oldestFactor
+           + (unsigned char)haystack[group->length];
+      haystack++;
+    }
+  }
+
+  // try to use stack instead of heap (avoid slow memory allocations if possible)
+  const size_t MaxLocalMemory = 16;
+  uint64_t localMemory[MaxLocalMemory];
+  uint64_t* hashes = localMemory;
+  // stack too small => allocate heap
+  if (set->numGroups > MaxLocalMemory)
+  {
+    hashes = (uint64_t*)malloc(set->numGroups * sizeof(uint64_t));
+    if (hashes == NULL)
+      return NULL;
+  }
+
+  // hash of the first window of each length (if haystack is long enough)
+  size_t numActive = 0;
+  while (numActive < set->numGroups && set->groups[numActive].length <= haystackLength)
+  {
+    hashes[numActive] = rollingHash(haystack, set->groups[numActive].length);
+    numActive++;
+  }
+
+  // assume no match
+  const char* result = NULL;
+  const char* haystackEnd = haystack + haystackLength;
+  for (;;)
+  {
+    // check windows of all lengths starting at the current position, shortest first
+    // (usually the filter already rejects)
+    size_t g;
+    for (g = 0; g < numActive; g++)
+      if (rabinKarpMaybe(&set->groups[g], hashes[g]) && rabinKarpLookup(&set->groups[g], hashes[g], haystack))
+      {
+        result = haystack;
+        if (matchLength)
+          *matchLength = set->groups[g].length;
+        break;
+      }
+    if (result)
+      break;
+
+    // longest needles don't fit anymore ?
+    size_t bytesLeft = haystackEnd - haystack;
+    while (numActive > 0 && set->groups[numActive - 1].length >= bytesLeft)
+      numActive--;
+    if (numActive == 0)
+      break;
+
+    // roll all hashes
+    for (g = 0; g < numActive; g++)
+    {
+      const RabinKarpGroup* group = &set->groups[g];
+      hashes[g] = hashes[g] * RollingHashBase
+                - (unsigned char)haystack[0] * group->oldestFactor
+                + (unsigned char)haystack[group->length];
+    }
+    haystack++;
+  }
+
+  // clean up heap (if used)
+  if (hashes != localMemory)
+    free(hashes);
+
+  // points to match position or NULL if not found
+  return result;
+}
+
+
+// //////////////////////////////////////////////////////////
+
+
+/// super-fast for short strings (less than about 8 bytes), else use searchSimple or searchBoyerMooreHorspool
+const char* searchNative(const char* haystack, size_t haystackLength,
+                         const char* needle,   size_t needleLength)
+{
+  // uses memchr() for the first byte, then memcmp to verify it's a valid match
+
+  // detect invalid input
+  if (!haystack || !needle || haystackLength < needleLength)
+    return NULL;
+
+  // empty needle matches everything
+  if (needleLength == 0)
+    return haystack;
+
+  // shorter code for just one character
+  if (needleLength == 1)
+    return (const char*)memchr(haystack, *needle, haystackLength);
+
+  haystackLength -= needleLength - 1;
+  // points beyond last considered byte
+  const char* haystackEnd = haystack + haystackLength;
+
+  // look for first byte
+  while ((haystack = (const char*)memchr(haystack, *needle, haystackLength)) != NULL)
+  {
+    // does last byte match, too ?
+    if (haystack[needleLength - 1] == needle[needleLength - 1])
+      // okay, perform full comparison, skip first and last byte (if just 2 bytes => already finished)
+      if (needleLength == 2 || memcmp(haystack + 1, needle + 1, needleLength - 2) == 0)
+        return haystack;
+
+    // compute number of remaining bytes
+    haystackLength = haystackEnd - haystack;
+    if (haystackLength == 0)
+      return NULL;
+
+    // keep going
+    haystack++;
+    haystackLength--;
+  }
+
+  // needle not found in haystack
+  return NULL;
+}
+
+
+// //////////////////////////////////////////////////////////
+
+
+/// load 8 bytes in little endian order, no alignment required
+static uint64_t swarLoad(const char* data)
+{
+  // memcpy() becomes a single load instruction, assembling the value byte by byte doesn't survive all optimizations
+  uint64_t result;
+  memcpy(&result, data, sizeof(result));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+  result = __builtin_bswap64(result);
+#endif
+  return result;
+}
+
+
+/// set the highest bit of each zero byte, all other bits are cleared
+/** unlike the well-known (x - 0x01..) & ~x & 0x80.. there are no false positives caused by borrows **/
+static uint64_t swarZeroBytes(uint64_t x)
+{
+  const uint64_t Low7Bits = 0x7F7F7F7F7F7F7F7FULL;
+  return ~(((x & Low7Bits) + Low7Bits) | x | Low7Bits);
+}
+
+
+/// index of the lowest byte whose highest bit is set (mask must not be zero)
+static size_t swarFirstByte(uint64_t mask)
+{
+#ifdef __GNUC__
+  return __builtin_ctzll(mask) / 8;
+#else
+  size_t index = 0;
+  while ((mask & 0x80) == 0)
+  {
+    mask >>= 8;
+    index++;
+  }
+  return index;
+#endif
+}
+
+
+/// compare two memory blocks, 8 bytes per step
+static int swarEqual(const char* a, const char* b, size_t length)
+{
+  for (; length >= 8; length -= 8, a += 8, b += 8)
+    if (swarLoad(a) != swarLoad(b))
+      return 0;
+
+  // at most 7 bytes left
+  for (; length > 0; length--)
+    if (*a++ != *b++)
+      return 0;
+
+  return 1;
+}
+
+
+/// SWAR ("SIMD within a register"): compare first and last byte of needle at 8 positions per step with plain 64 bit arithmetic
+/** portable alternative to searchSimple / searchNative, neither intrinsics nor memchr() required **/
+const char* searchSWAR(const char* haystack, size_t haystackLength,
+                       const char* needle,   size_t needleLength)
+{
+  // detect invalid input
+  if (!haystack || !needle || haystackLength < needleLength)
+    return NULL;
+
+  // empty needle matches everything
+  if (needleLength == 0)
+    return haystack;
+
+  // replicate first and last byte of needle
+  const uint64_t Broadcast = 0x0101010101010101ULL;
+  const uint64_t first     = Broadcast * (unsigned char)needle[0];
+  const uint64_t last      = Broadcast * (unsigned char)needle[needleLength - 1];
+
+  // match impossible if less than needleLength bytes left
+  const size_t numPositions = haystackLength - needleLength + 1;
+  // first and last byte already match, compare the rest
+  const size_t innerLength  = needleLength > 2 ? needleLength - 2 : 0;
+
+  size_t pos = 0;
+  for (; pos + 8 <= numPositions; pos += 8)
+  {
+    // highest bit of a byte is set if first and last byte match at that position
+    uint64_t candidates = swarZeroBytes(swarLoad(haystack + pos)                    ^ first) &
+                          swarZeroBytes(swarLoad(haystack + pos + needleLength - 1) ^ last);
+
+    while (candidates != 0)
+    {
+      size_t current = pos + swarFirstByte(candidates);
+      if (swarEqual(haystack + current + 1, needle + 1, innerLength))
+        return haystack + current;
+
+      // remove lowest candidate
+      candidates &= candidates - 1;
+    }
+  }
+
+  // less than 8 positions left
+  for (; pos < numPositions; pos++)
+    if (haystack[pos]                    == needle[0] &&
+        haystack[pos + needleLength - 1] == needle[needleLength - 1] &&
+        swarEqual(haystack + pos + 1, needle + 1, innerLength))
+      return haystack + pos;
+
+  // needle not found in haystack
+  return NULL;
+}
+
+
+/// SWAR, ignoring ASCII case: letters are compared after setting bit 5 (0x20) which turns 'A'..'Z' into 'a'..'z'
+/** (x | 0x20) == 'a' is only true for x = 'a' or x = 'A', therefore bytes of the haystack can be ORed blindly
+    as long as the needle's byte is a letter **/
+const char* searchSWARNoCase(const char* haystack, size_t haystackLength,
+                             const char* needle,   size_t needleLength)
+{
+  // detect invalid input
+  if (!haystack || !needle || haystackLength < needleLength)
+    return NULL;
+
+  // empty needle matches everything
+  if (needleLength == 0)
+    return haystack;
+
+  unsigned char firstByte = foldCase((unsigned char)needle[0]);
+  unsigned char lastByte  = foldCase((unsigned char)needle[needleLength - 1]);
+
+  // replicate first and last byte of needle, OR 0x20 only if they are letters
+  const uint64_t Broadcast = 0x0101010101010101ULL;
+  const uint64_t first     = Broadcast * firstByte;
+  const uint64_t last      = Broadcast * lastByte;
+  const uint64_t firstCase = Broadcast * (firstByte >= 'a' && firstByte <= 'z' ? 0x20 : 0);
+  const uint64_t lastCase  = Broadcast * (lastByte  >= 'a' && lastByte  <= 'z' ? 0x20 : 0);
+
+  // match impossible if less than needleLength bytes left
+  const size_t numPositions = haystackLength - needleLength + 1;
+  // first and last byte already match, compare the rest
+  const size_t innerLength  = needleLength > 2 ? needleLength - 2 : 0;
+
+  size_t pos = 0;
+  for (; pos + 8 <= numPositions; pos += 8)
+  {
+    uint64_t candidates = swarZeroBytes((swarLoad(haystack + pos)                    | firstCase) ^ first) &
+                          swarZeroBytes((swarLoad(haystack + pos + needleLength - 1) | lastCase)  ^ last);
+
+    while (candidates != 0)
+    {
+      size_t current = pos + swarFirstByte(candidates);
+      if (equalNoCase(haystack + current + 1, needle + 1, innerLength))
+        return haystack + current;
+
+      // remove lowest candidate
+      candidates &= candidates - 1;
+    }
+  }
+
+  // less than 8 positions left
+  for (; pos < numPositions; pos++)
+    if (foldCase((unsigned char)haystack[pos])                    == firstByte &&
+        foldCase((unsigned char)haystack[pos + needleLength - 1]) == lastByte  &&
+        equalNoCase(haystack + pos + 1, needle + 1, innerLength))
+      return haystack + pos;
+
+  // needle not found in haystack
+  return NULL;
+}
+
+
+// //////////////////////////////////////////////////////////
+
+
+/// SSE4.2 string instructions: PCMPESTRI compares a 16 byte block against needle (or its first 16 bytes)
+/** partial matches at the end of a block are reported, too, and then verified by memcmp **/
+#ifdef SEARCH_X86_SIMD
+__attribute__((target("sse4.2")))
+static const char* searchSSE42Kernel(const char* haystack, size_t haystackLength,
+                                     const char* needle,   size_t needleLength)
+{
+  // needle may be located at the end of a page, therefore copy it first
+  const size_t BlockSize = 16;
+  char prefix[BlockSize];
+  size_t prefixLength = needleLength < BlockSize ? needleLength : BlockSize;
+  memset(prefix, 0, BlockSize);
+  memcpy(prefix, needle, prefixLength);
+  const __m128i needleBlock = _mm_loadu_si128((const __m128i*)prefix);
+  // must be a compile-time constant (an 8 bit immediate), even without optimizations
+  enum { Mode = _SIDD_UBYTE_OPS | _SIDD_CMP_EQUAL_ORDERED | _SIDD_LEAST_SIGNIFICANT };
+
+  size_t pos = 0;
+  while (pos + BlockSize <= haystackLength)
+  {
+    __m128i block = _mm_loadu_si128((const __m128i*)(haystack + pos));
+    // index of first (partial) match in block or 16 if none
+    int index = _mm_cmpestri(needleBlock, (int)prefixLength, block, (int)BlockSize, Mode);
+    if (index == (int)BlockSize)
+    {
+      pos += BlockSize;
+      continue;
+    }
+
+    // verify candidate
+    pos += index;
+    if (pos + needleLength > haystackLength)
+      return NULL;
+    if (memcmp(haystack + pos, needle, needleLength) == 0)
+      return haystack + pos;
+    pos++;
+  }
+
+  // less than 16 bytes left
+  return searchNative(haystack + pos, haystackLength - pos, needle, needleLength);
+}
+#endif
+
+
+/// SSE4.2 string instructions: PCMPESTRI compares a 16 byte block against needle (or its first 16 bytes), falls back to searchNative if not supported
+const char* searchSSE42(const char* haystack, size_t haystackLength,
+                        const char* needle,   size_t needleLength)
+{
+  // detect invalid input
+  if (!haystack || !needle || haystackLength < needleLength)
+    return NULL;
+
+  // empty needle matches everything
+  if (needleLength == 0)
+    return haystack;
+
+#ifdef SEARCH_X86_SIMD
+  if (__builtin_cpu_supports("sse4.2"))
+    return searchSSE42Kernel(haystack, haystackLength, needle, needleLength);
+#endif
+
+  return searchNative(haystack, haystackLength, needle, needleLength);
+}
+
+
+/// AVX2: compare 32 positions at once with needle's first and last byte, then verify candidates with memcmp
+/** based on Wojciech Mula's "SIMD-friendly algorithms for substring searching" **/
+#ifdef SEARCH_X86_SIMD
+__attribute__((target("avx2,bmi")))
+static const char* searchAVX2Kernel(const char* haystack, size_t haystackLength,
+                                    const char* needle,   size_t needleLength)
+{
+  const size_t BlockSize = 32;
+  const size_t lastPos   = needleLength - 1;
+  const __m256i first    = _mm256_set1_epi8(needle[0]);
+  const __m256i last     = _mm256_set1_epi8(needle[lastPos]);
+
+  size_t pos = 0;
+  // each iteration covers 32 start positions
+  while (pos + lastPos + BlockSize <= haystackLength)
+  {
+    __m256i blockFirst = _mm256_loadu_si256((const __m256i*)(haystack + pos));
+    __m256i blockLast  = _mm256_loadu_si256((const __m256i*)(haystack + pos + lastPos));
+    __m256i equal      = _mm256_and_si256(_mm256_cmpeq_epi8(blockFirst, first),
+                                          _mm256_cmpeq_epi8(blockLast,  last));
+    uint32_t candidates = (uint32_t)_mm256_movemask_epi8(equal);
+
+    // first and last byte match, check the bytes in between
+    while (candidates != 0)
+    {
+      size_t offset = pos + __builtin_ctz(candidates);
+      if (needleLength <= 2 || memcmp(haystack + offset + 1, needle + 1, needleLength - 2) == 0)
+        return haystack + offset;
+      candidates &= candidates - 1;
+    }
+
+    pos += BlockSize;
+  }
+
+  // less than 32 positions left
+  return searchNative(haystack + pos, haystackLength - pos, needle, needleLength);
+}
+#endif
+
+
+/// AVX2: compare 32 positions at once with needle's first and last byte, falls back to searchNative if not supported
+const char* searchAVX2(const char* haystack, size_t haystackLength,
+                       const char* needle,   size_t needleLength)
+{
+  // detect invalid input
+  if (!haystack || !needle || haystackLength < needleLength)
+    return NULL;
+
+  // empty needle matches everything
+  if (needleLength == 0)
+    return haystack;
+
+  // shorter code for just one character
+  if (needleLength == 1)
+    return (const char*)memchr(haystack, *needle, haystackLength);
+
+#ifdef SEARCH_X86_SIMD
+  if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("bmi"))
+    return searchAVX2Kernel(haystack, haystackLength, needle, needleLength);
+#endif
+
+  return searchNative(haystack, haystackLength, needle, needleLength);
+}
+
+
+/// AVX2, ignoring ASCII case: same as searchAVX2Kernel, but lanes are ORed with 0x20 if the needle's byte is a letter
+#ifdef SEARCH_X86_SIMD
+__attribute__((target("avx2,bmi")))
+static const char* searchAVX2NoCaseKernel(const char* haystack, size_t haystackLength,
+                                          const char* needle,   size_t needleLength)
+{
+  const size_t BlockSize = 32;
+  const size_t lastPos   = needleLength - 1;
+  unsigned char firstByte = foldCase((unsigned char)needle[0]);
+  unsigned char lastByte  = foldCase((unsigned char)needle[lastPos]);
+  const __m256i first     = _mm256_set1_epi8((char)firstByte);
+  const __m256i last      = _mm256_set1_epi8((char)lastByte);
+  const __m256i firstCase = _mm256_set1_epi8(firstByte >= 'a' && firstByte <= 'z' ? 0x20 : 0);
+  const __m256i lastCase  = _mm256_set1_epi8(lastByte  >= 'a' && lastByte  <= 'z' ? 0x20 : 0);
+
+  size_t pos = 0;
+  // each iteration covers 32 start positions
+  while (pos + lastPos + BlockSize <= haystackLength)
+  {
+    __m256i blockFirst = _mm256_or_si256(_mm256_loadu_si256((const __m256i*)(haystack + pos)),           firstCase);
+    __m256i blockLast  = _mm256_or_si256(_mm256_loadu_si256((const __m256i*)(haystack + pos + lastPos)), lastCase);
+    __m256i equal      = _mm256_and_si256(_mm256_cmpeq_epi8(blockFirst, first),
+                                          _mm256_cmpeq_epi8(blockLast,  last));
+    uint32_t candidates = (uint32_t)_mm256_movemask_epi8(equal);
+
+    // first and last byte match, check the bytes in between
+    while (candidates != 0)
+    {
+      size_t offset = pos + __builtin_ctz(candidates);
+      if (equalNoCase(haystack + offset + 1, needle + 1, needleLength > 2 ? needleLength - 2 : 0))
+        return haystack + offset;
+      candidates &= candidates - 1;
+    }
+
+    pos += BlockSize;
+  }
+
+  // less than 32 positions left
+  return searchSWARNoCase(haystack + pos, haystackLength - pos, needle, needleLength);
+}
+#endif
+
+
+/// AVX2, ignoring ASCII case, falls back to searchSWARNoCase if not supported
+const char* searchAVX2NoCase(const char* haystack, size_t haystackLength,
+                             const char* needle,   size_t needleLength)
+{
+  // detect invalid input
+  if (!haystack || !needle || haystackLength < needleLength)
+    return NULL;
+
+  // empty needle matches everything
+  if (needleLength == 0)
+    return haystack;
+
+#ifdef SEARCH_X86_SIMD
+  if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("bmi"))
+    return searchAVX2NoCaseKernel(haystack, haystackLength, needle, needleLength);
+#endif
+
+  return searchSWARNoCase(haystack, haystackLength, needle, needleLength);
+}
+
+
+/// AVX-512BW: compare 64 positions at once with needle's first and last byte, the tail is processed with masked loads
+#ifdef SEARCH_X86_SIMD
+__attribute__((target("avx512f,avx512bw,bmi")))
+static const char* searchAVX512Kernel(const char* haystack, size_t haystackLength,
+                                      const char* needle,   size_t needleLength)
+{
+  const size_t BlockSize = 64;
+  const size_t lastPos   = needleLength - 1;
+  const __m512i first    = _mm512_set1_epi8(needle[0]);
+  const __m512i last     = _mm512_set1_epi8(needle[lastPos]);
+
+  // number of positions where a match could begin
+  const size_t numPositions = haystackLength - lastPos;
+
+  size_t pos = 0;
+  while (pos < numPositions)
+  {
+    // less than 64 positions left: load only the remaining bytes (masked loads never fault)
+    __mmask64 valid = ~(__mmask64)0;
+    if (numPositions - pos < BlockSize)
+      valid = ((__mmask64)1 << (numPositions - pos)) - 1;
+
+    __m512i   blockFirst = _mm512_maskz_loadu_epi8(valid, haystack + pos);
+    __m512i   blockLast  = _mm512_maskz_loadu_epi8(valid, haystack + pos + lastPos);
+    __mmask64 equalFirst = _mm512_mask_cmpeq_epi8_mask(valid,      blockFirst, first);
+    uint64_t  candidates = _mm512_mask_cmpeq_epi8_mask(equalFirst, blockLast,  last);
+
+    // first and last byte match, check the bytes in between
+    while (candidates != 0)
+    {
+      size_t offset = pos + __builtin_ctzll(candidates);
+      if (needleLength <= 2 || memcmp(haystack + offset + 1, needle + 1, needleLength - 2) == 0)
+        return haystack + offset;
+      candidates &= candidates - 1;
+    }
+
+    pos += BlockSize;
+  }
+
+  // needle not found in haystack
+  return NULL;
+}
+#endif
+
+
+/// AVX-512BW: compare 64 positions at once with needle's first and last byte, falls back to searchAVX2 if not supported
+const char* searchAVX512(const char* haystack, size_t haystackLength,
+                         const char* needle,   size_t needleLength)
+{
+  // detect invalid input
+  if (!haystack || !needle || haystackLength < needleLength)
+    return NULL;
+
+  // empty needle matches everything
+  if (needleLength == 0)
+    return haystack;
+
+  // shorter code for just one character
+  if (needleLength == 1)
+    return (const char*)memchr(haystack, *needle, haystackLength);
+
+#ifdef SEARCH_X86_SIMD
+  if (__builtin_cpu_supports("avx512bw") && __builtin_cpu_supports("bmi"))
+    return searchAVX512Kernel(haystack, haystackLength, needle, needleLength);
+#endif
+
+  return searchAVX2(haystack, haystackLength, needle, needleLength);
+}
+
+
+/// AVX-512BW: count bytes in 64 byte blocks, tail is processed with masked loads
+#ifdef SEARCH_X86_SIMD
+__attribute__((target("avx512f,avx512bw,popcnt")))
+static size_t countNewlinesAVX512(const char* data, size_t length)
+{
+  const size_t  BlockSize = 64;
+  const __m512i newline   = _mm512_set1_epi8('\n');
+
+  size_t count = 0;
+  size_t pos   = 0;
+  for (; pos + BlockSize <= length; pos += BlockSize)
+  {
+    __m512i block = _mm512_loadu_si512((const void*)(data + pos));
+    count += __builtin_popcountll(_mm512_cmpeq_epi8_mask(block, newline));
+  }
+
+  // remaining bytes
+  if (pos < length)
+  {
+    __mmask64 valid = ((__mmask64)1 << (length - pos)) - 1;
+    __m512i   block = _mm512_maskz_loadu_epi8(valid, data + pos);
+    count += __builtin_popcountll(_mm512_mask_cmpeq_epi8_mask(valid, block, newline));
+  }
+
+  return count;
+}
+#endif
+
+
+/// count newline bytes (uses AVX-512BW if available)
+size_t countNewlines(const char* data, size_t length)
+{
+  // detect invalid input
+  if (!data)
+    return 0;
+
+#ifdef SEARCH_X86_SIMD
+  if (__builtin_cpu_supports("avx512bw") && __builtin_cpu_supports("popcnt"))
+    return countNewlinesAVX512(data, length);
+#endif
+
+  // simple loop, easy to auto-vectorize
+  size_t count = 0;
+  size_t i;
+  for (i = 0; i < length; i++)
+    count += (data[i] == '\n');
+  return count;
+}
+
+
+// //////////////////////////////////////////////////////////
+
+
+/// rank of each byte in typical data (0 = rarest, 255 = most frequent)
+/** counted over a mix of English documentation, C/C++ headers, Python source and x86-64 executables **/
+static const unsigned char ByteFrequency[256] =
+{
+  254, 195, 164, 148, 158, 154, 134, 141, 185, 176, 243,  86, 104,  84, 149, 196, // 0x00
+  163, 116, 138,  81,  99,  80,  61,  57, 144,  21,  42,  51,  77,  49,  76, 159, // 0x10
+  255, 115, 213, 201, 193, 146, 136, 218, 230, 227, 223, 140, 234, 215, 226, 239, // 0x20
+  217, 214, 198, 184, 179, 188, 175, 165, 178, 189, 209, 187, 199, 202, 200, 113, // 0x30
+  161, 220, 192, 216, 204, 231, 191, 181, 229, 221, 137, 162, 224, 194, 211, 212, // 0x40
+  207, 112, 210, 233, 222, 186, 166, 151, 180, 150, 131, 174, 182, 177,  96, 244, // 0x50
+  168, 246, 232, 242, 241, 253, 236, 228, 235, 250, 169, 205, 245, 237, 249, 247, // 0x60
+  240, 152, 248, 251, 252, 238, 206, 197, 208, 219, 155, 157, 153, 156, 108,  60, // 0x70
+  145,  92,  63, 173, 170, 172,  70,  54, 109, 203,  35, 190,  78, 171,  53,  34, // 0x80
+  133, 130,  52,  64,  75,  56,  27,  18,  73,  12,  11,   8,  50,  15,  16,   0, // 0x90
+  100,   1,  19,  23,  25,   5,   4,   6,  72,  10,  22,  40,  47,  24,   9,  20, // 0xA0
+   95,   7,  28,  32,  44,  30, 106,  33, 114,  71, 126,  39,  85,  58, 120,  93, // 0xB0
+  167, 122, 105, 139, 121,  97, 132, 143,  83, 119,  38,  14,  26,  17,  55,  13, // 0xC0
+  135,  87, 117,  48,   3,  31,  29,  37, 125,  94,  45, 102,   2,  98,  68, 110, // 0xD0
+  118,  65,  89,  59,  79,  46,  66,  82, 183, 160,  62, 128, 101, 103, 127, 142, // 0xE0
+  111,  41,  74,  67,  36,  43, 129,  91, 123,  69,  90,  88, 107, 124, 147, 225  // 0xF0
+};
+
+
+/// count bytes of a sample (e.g. the first few kilobytes of the haystack) and convert to ranks (0 = rarest, 255 = most frequent)
+void trainByteFrequency(unsigned char frequency[256], const char* sample, size_t sampleLength)
+{
+  const size_t AlphabetSize = 256;
+  size_t count[AlphabetSize];
+  size_t i;
+  for (i = 0; i < AlphabetSize; i++)
+    count[i] = 0;
+  for (i = 0; i < sampleLength; i++)
+    count[(unsigned char)sample[i]]++;
+
+  // rank = number of bytes which are rarer,
+  // bytes with the same count (especially those not found in the sample) are ordered by the built-in table
+  for (i = 0; i < AlphabetSize; i++)
+  {
+    size_t rank = 0;
+    size_t j;
+    for (j = 0; j < AlphabetSize; j++)
+      if (count[j] < count[i] || (count[j] == count[i] && ByteFrequency[j] < ByteFrequency[i]))
+        rank++;
+    frequency[i] = (unsigned char)rank;
+  }
+}
+
+
+/// like searchNative, but memchr() looks for the rarest byte of needle (ranked by a frequency table) instead of its first byte
+const char* searchNativeRareByteTable(const char* haystack, size_t haystackLength,
+                                      const char* needle,   size_t needleLength,
+                                      const unsigned char frequency[256])
+{
+  // detect invalid input
+  if (!haystack || !needle || !frequency || haystackLength < needleLength)
+    return NULL;
+
+  // empty needle matches everything
+  if (needleLength == 0)
+    return haystack;
+
+  // shorter code for just one character
+  if (needleLength == 1)
+    return (const char*)memchr(haystack, *needle, haystackLength);
+
+  // find the two rarest bytes: memchr() looks for the rarest, the second rarest is checked before a full comparison
+  size_t rarest = 0;
+  size_t second = 1;
+  if (frequency[(unsigned char)needle[1]] < frequency[(unsigned char)needle[0]])
+  {
+    rarest = 1;
+    second = 0;
+  }
+  size_t pos;
+  for (pos = 2; pos < needleLength; pos++)
+  {
+    unsigned char current = frequency[(unsigned char)needle[pos]];
+    if (current < frequency[(unsigned char)needle[rarest]])
+    {
+      second = rarest;
+      rarest = pos;
+    }
+    else if (current < frequency[(unsigned char)needle[second]])
+      second = pos;
+  }
+
+  const char anchor = needle[rarest];
+  const char verify = needle[second];
+
+  // scan only where the rarest byte of a match could be
+  haystackLength -= needleLength - 1;
+  const char* scan    = haystack + rarest;
+  const char* scanEnd = scan + haystackLength;
+
+  while ((scan = (const char*)memchr(scan, anchor, scanEnd - scan)) != NULL)
+  {
+    // needle would start here
+    const char* candidate = scan - rarest;
+
+    // does the second rarest byte match, too ? then perform full comparison
+    if (candidate[second] == verify && memcmp(candidate, needle, needleLength) == 0)
+      return candidate;
+
+    // keep going
+    if (++scan == scanEnd)
+      break;
+  }
+
+  // needle not found in haystack
+  return NULL;
+}
+
+
+/// like searchNative, but memchr() looks for the rarest byte of needle (according to a built-in frequency table)
+const char* searchNativeRareByte(const char* haystack, size_t haystackLength,
+                                 const char* needle,   size_t needleLength)
+{
+  return searchNativeRareByteTable(haystack, haystackLength, needle, needleLength, ByteFrequency);
+}
+
+
+// //////////////////////////////////////////////////////////
+
+
+/// decode one UTF-8 character, returns its length in bytes or 0 if invalid (truncated, overlong, surrogate, too large)
+static size_t decodeUtf8(const unsigned char* text, size_t length, uint32_t* codePoint)
+{
+  if (length == 0)
+    return 0;
+
+  // ASCII
+  unsigned char lead = text[0];
+  if (lead < 0x80)
+  {
+    *codePoint = lead;
+    return 1;
+  }
+
+  // number of bytes and smallest code point that requires them
+  size_t   numBytes;
+  uint32_t minimum;
+  uint32_t result;
+  if      ((lead & 0xE0) == 0xC0) { numBytes = 2; minimum = 0x80;    result = lead & 0x1F; }
+  else if ((lead & 0xF0) == 0xE0) { numBytes = 3; minimum = 0x800;   result = lead & 0x0F; }
+  else if ((lead & 0xF8) == 0xF0) { numBytes = 4; minimum = 0x10000; result = lead & 0x07; }
+  else
+    return 0;
+
+  if (length < numBytes)
+    return 0;
+
+  size_t i;
+  for (i = 1; i < numBytes; i++)
+  {
+    if ((text[i] & 0xC0) != 0x80)
+      return 0;
+    result = (result << 6) | (text[i] & 0x3F);
+  }
+
+  if (result < minimum || result > 0x10FFFF || (result >= 0xD800 && result <= 0xDFFF))
+    return 0;
+
+  *codePoint = result;
+  return numBytes;
+}
+
+
+/// encode a code point as UTF-8, returns its length in bytes
+static size_t encodeUtf8(uint32_t codePoint, unsigned char* text)
+{
+  if (codePoint < 0x80)
+  {
+    text[0] = (unsigned char)codePoint;
+    return 1;
+  }
+  if (codePoint < 0x800)
+  {
+    text[0] = (unsigned char)(0xC0 |  (codePoint >>  6));
+    text[1] = (unsigned char)(0x80 |  (codePoint        & 0x3F));
+    return 2;
+  }
+  if (codePoint < 0x10000)
+  {
+    text[0] = (unsigned char)(0xE0 |  (codePoint >> 12));
+    text[1] = (unsigned char)(0x80 | ((codePoint >>  6) & 0x3F));
+    text[2] = (unsigned char)(0x80 |  (codePoint        & 0x3F));
+    return 3;
+  }
+  text[0] = (unsigned char)(0xF0 |  (codePoint >> 18));
+  text[1] = (unsigned char)(0x80 | ((codePoint >> 12) & 0x3F));
+  text[2] = (unsigned char)(0x80 | ((codePoint >>  6) & 0x3F));
+  text[3] = (unsigned char)(0x80 |  (codePoint        & 0x3F));
+  return 4;
+}
+
+
+/// simple case folding (to lower case) of ASCII, Latin-1, Latin Extended-A, Greek and Cyrillic plus a few compatibility characters
+/** ß and ẞ are handled by compileUtf8Pattern ("ss"), Turkish dotted and dotless i are left alone **/
+static uint32_t foldCodePoint(uint32_t c)
+{
+  // ASCII and Latin-1
+  if (c >= 'A'    && c <= 'Z')
+    return c + 32;
+  if (c >= 0x00C0 && c <= 0x00DE && c != 0x00D7)
+    return c + 32;
+  if (c == 0x00B5) // micro sign => mu
+    return 0x03BC;
+  if (c == 0x0178) // Y with diaeresis
+    return 0x00FF;
+  if (c == 0x017F) // long s
+    return 's';
+
+  // Latin Extended-A: upper case letters have even code points ...
+  if ((c >= 0x0100 && c <= 0x012F) || (c >= 0x0132 && c <= 0x0137) || (c >= 0x014A && c <= 0x0177))
+    return c | 1;
+  // ... or odd code points
+  if ((c >= 0x0139 && c <= 0x0148) || (c >= 0x0179 && c <= 0x017E))
+    return (c & 1) ? c + 1 : c;
+
+  // Greek, including accented vowels and final sigma
+  if (c == 0x0386)
+    return 0x03AC;
+  if (c >= 0x0388 && c <= 0x038A)
+    return c + 37;
+  if (c == 0x038C)
+    return 0x03CC;
+  if (c == 0x038E || c == 0x038F)
+    return c + 63;
+  if ((c >= 0x0391 && c <= 0x03A1) || (c >= 0x03A3 && c <= 0x03AB))
+    return c + 32;
+  if (c == 0x03C2)
+    return 0x03C3;
+
+  // Cyrillic
+  if (c >= 0x0400 && c <= 0x040F)
+    return c + 80;
+  if (c >= 0x0410 && c <= 0x042F)
+    return c + 32;
+  if ((c >= 0x0460 && c <= 0x0481) || (c >= 0x048A && c <= 0x04BF) || (c >= 0x04D0 && c <= 0x052F))
+    return c | 1;
+  if (c == 0x04C0)
+    return 0x04CF;
+  if (c >= 0x04C1 && c <= 0x04CE)
+    return (c & 1) ? c + 1 : c;
+
+  // Kelvin and Angstrom sign
+  if (c == 0x212A)
+    return 'k';
+  if (c == 0x212B)
+    return 0x00E5;
+
+  return c;
+}
+
+
+/// a single character of a Utf8Pattern: all its case variants, UTF-8 encoded
+typedef struct
+{
+  /// folded code point (or a byte of invalid UTF-8)
+  uint32_t      folded;
+  /// at most four variants, e.g. 's', 'S' and long s
+  unsigned char numVariants;
+  unsigned char length[4];
+  unsigned char bytes [4][4];
+  /// this and the next character are both 's' => may be matched by ß or ẞ, too
+  unsigned char sharpS;
+} Utf8Unit;
+
+/// ß and ẞ, the alternatives for "ss"
+static const Utf8Unit SharpS = { 's', 2, { 2, 3 }, { { 0xC3, 0x9F }, { 0xE1, 0xBA, 0x9E } }, 0 };
+
+/// a compiled case-insensitive UTF-8 needle
+struct Utf8Pattern
+{
+  size_t        numUnits;
+  Utf8Unit*     units;
+  /// longest run of units consisting of single-byte variants only, located by searchAVX2NoCase
+  size_t        anchorFirst;
+  size_t        anchorLength;
+  char*         anchor;
+  /// maximum number of bytes matched by the units in front of the anchor
+  size_t        maxPrefixBytes;
+  /// if there is no anchor: non-zero for each byte a match may start with
+  unsigned char startBytes[256];
+};
+
+
+/// add a variant to a unit (if not already known)
+static void addUtf8Variant(Utf8Unit* unit, uint32_t codePoint)
+{
+  unsigned char bytes[4];
+  size_t length = encodeUtf8(codePoint, bytes);
+
+  unsigned char i;
+  for (i = 0; i < unit->numVariants; i++)
+    if (unit->length[i] == length && memcmp(unit->bytes[i], bytes, length) == 0)
+      return;
+
+  if (unit->numVariants == 4)
+    return;
+
+  unit->length[unit->numVariants] = (unsigned char)length;
+  memcpy(unit->bytes[unit->numVariants], bytes, length);
+  unit->numVariants++;
+}
+
+
+/// find all code points which are folded to the same code point
+static void createUtf8Unit(Utf8Unit* unit, uint32_t folded)
+{
+  memset(unit, 0, sizeof(Utf8Unit));
+  unit->folded = folded;
+  // folded code point comes first (the anchor consists of these)
+  addUtf8Variant(unit, folded);
+
+  // foldCodePoint() only changes code points up to U+052F, except Kelvin and Angstrom sign
+  uint32_t c;
+  for (c = 0; c < 0x0530; c++)
+    if (foldCodePoint(c) == folded)
+      addUtf8Variant(unit, c);
+  if (foldCodePoint(0x212A) == folded)
+    addUtf8Variant(unit, 0x212A);
+  if (foldCodePoint(0x212B) == folded)
+    addUtf8Variant(unit, 0x212B);
+}
+
+
+/// compile needle into all its case variants, returns NULL if out of memory
+Utf8Pattern* compileUtf8Pattern(const char* needle, size_t needleLength)
+{
+  // detect invalid input
+  if (!needle)
+    return NULL;
+
+  Utf8Pattern* pattern = (Utf8Pattern*)calloc(1, sizeof(Utf8Pattern));
+  if (!pattern)
+    return NULL;
+
+  // each unit consumes at least one byte of needle (ß and ẞ produce two units from two or three bytes)
+  pattern->units  = (Utf8Unit*)malloc((needleLength + 1) * sizeof(Utf8Unit));
+  pattern->anchor = (char*)    malloc( needleLength + 1);
+  if (!pattern->units || !pattern->anchor)
+  {
+    freeUtf8Pattern(pattern);
+    return NULL;
+  }
+
+  const unsigned char* text = (const unsigned char*)needle;
+  size_t pos = 0;
+  while (pos < needleLength)
+  {
+    Utf8Unit* unit = &pattern->units[pattern->numUnits];
+
+    uint32_t codePoint;
+    size_t numBytes = decodeUtf8(text + pos, needleLength - pos, &codePoint);
+    if (numBytes == 0)
+    {
+      // invalid UTF-8, match byte as it is
+      memset(unit, 0, sizeof(Utf8Unit));
+      unit->folded      = 0xFFFFFFFF;
+      unit->numVariants = 1;
+      unit->length[0]   = 1;
+      unit->bytes [0][0] = text[pos];
+      pattern->numUnits++;
+      pos++;
+      continue;
+    }
+    pos += numBytes;
+
+    // ß and ẞ become "ss"
+    if (codePoint == 0x00DF || codePoint == 0x1E9E)
+    {
+      createUtf8Unit(unit,     's');
+      createUtf8Unit(unit + 1, 's');
+      pattern->numUnits += 2;
+      continue;
+    }
+
+    createUtf8Unit(unit, foldCodePoint(codePoint));
+    pattern->numUnits++;
+  }
+
+  // any "ss" may be matched by ß or ẞ
+  size_t i;
+  for (i = 0; i + 1 < pattern->numUnits; i++)
+    if (pattern->units[i].folded == 's' && pattern->units[i + 1].folded == 's')
+      pattern->units[i].sharpS = 1;
+
+  // longest run of units whose variants are single bytes: they behave exactly like searchAVX2NoCase
+  size_t runFirst = 0;
+  for (i = 0; i <= pattern->numUnits; i++)
+  {
+    int simple = i < pattern->numUnits;
+    unsigned char v;
+    for (v = 0; simple && v < pattern->units[i].numVariants; v++)
+      simple = pattern->units[i].length[v] == 1;
+
+    if (simple)
+      continue;
+
+    // end of a run
+    if (i - runFirst > pattern->anchorLength)
+    {
+      pattern->anchorFirst  = runFirst;
+      pattern->anchorLength = i - runFirst;
+    }
+    runFirst = i + 1;
+  }
+  for (i = 0; i < pattern->anchorLength; i++)
+    pattern->anchor[i] = (char)pattern->units[pattern->anchorFirst + i].bytes[0][0];
+
+  // leftmost match may begin up to maxPrefixBytes in front of the anchor
+  for (i = 0; i < pattern->anchorFirst; i++)
+  {
+    unsigned char v, longest = 0;
+    for (v = 0; v < pattern->units[i].numVariants; v++)
+      if (longest < pattern->units[i].length[v])
+        longest = pattern->units[i].length[v];
+    pattern->maxPrefixBytes += longest;
+  }
+
+  // first byte of each variant of the first unit
+  if (pattern->numUnits > 0)
+  {
+    const Utf8Unit* first = &pattern->units[0];
+    unsigned char v;
+    for (v = 0; v < first->numVariants; v++)
+      pattern->startBytes[first->bytes[v][0]] = 1;
+    if (first->sharpS)
+      for (v = 0; v < SharpS.numVariants; v++)
+        pattern->startBytes[SharpS.bytes[v][0]] = 1;
+  }
+
+  return pattern;
+}
+
+
+/// release memory of a compiled UTF-8 needle
+void freeUtf8Pattern(Utf8Pattern* pattern)
+{
+  if (!pattern)
+    return;
+
+  free(pattern->units);
+  free(pattern->anchor);
+  free(pattern);
+}
+
+
+/// length of the variant found at text (0 if none), UTF-8 is prefix-free => at most one variant matches
+static size_t matchUtf8Unit(const Utf8Unit* unit, const unsigned char* text, size_t available)
+{
+  unsigned char v;
+  for (v = 0; v < unit->numVariants; v++)
+    if (unit->length[v] <= available && memcmp(text, unit->bytes[v], unit->length[v]) == 0)
+      return unit->length[v];
+  return 0;
+}
+
+
+/// length of the variant ending right before text[pos] (0 if none), UTF-8 is suffix-free, too
+static size_t matchUtf8UnitBackward(const Utf8Unit* unit, const unsigned char* text, size_t pos)
+{
+  unsigned char v;
+  for (v = 0; v < unit->numVariants; v++)
+    if (unit->length[v] <= pos && memcmp(text + pos - unit->length[v], unit->bytes[v], unit->length[v]) == 0)
+      return unit->length[v];
+  return 0;
+}
+
+
+/// match units [unit, numUnits) starting at text[*pos], on success *pos points beyond the match
+static int matchUtf8Forward(const Utf8Pattern* pattern, size_t unit,
+                            const unsigned char* text, size_t textLength, size_t* pos)
+{
+  size_t current = *pos;
+  while (unit < pattern->numUnits)
+  {
+    size_t length;
+    // ß or ẞ instead of "ss"
+    if (pattern->units[unit].sharpS && (length = matchUtf8Unit(&SharpS, text + current, textLength - current)) > 0)
+    {
+      unit    += 2;
+      current += length;
+      continue;
+    }
+
+    length = matchUtf8Unit(&pattern->units[unit], text + current, textLength - current);
+    if (length == 0)
+      return 0;
+    unit++;
+    current += length;
+  }
+
+  *pos = current;
+  return 1;
+}
+
+
+/// match units [0, unit) ending right before text[*pos], on success *pos points to the beginning of the match
+static int matchUtf8Backward(const Utf8Pattern* pattern, size_t unit,
+                             const unsigned char* text, size_t* pos)
+{
+  size_t current = *pos;
+  while (unit > 0)
+  {
+    size_t length;
+    // ß or ẞ instead of "ss"
+    if (unit >= 2 && pattern->units[unit - 2].sharpS && (length = matchUtf8UnitBackward(&SharpS, text, current)) > 0)
+    {
+      unit    -= 2;
+      current -= length;
+      continue;
+    }
+
+    length = matchUtf8UnitBackward(&pattern->units[unit - 1], text, current);
+    if (length == 0)
+      return 0;
+    unit--;
+    current -= length;
+  }
+
+  *pos = current;
+  return 1;
+}
+
+
+/// case-insensitive UTF-8 search: the haystack isn't decoded, instead the pattern's variants are compared byte-wise,
+/// stores length of the match in matchLength (if not NULL)
+/** candidates are located by the longest ASCII part of the needle (using searchAVX2NoCase), if there is none,
+    by a table of possible first bytes **/
+const char* searchUtf8Pattern(const Utf8Pattern* pattern,
+                              const char* haystack, size_t haystackLength, size_t* matchLength)
+{
+  // detect invalid input
+  if (!pattern || !haystack)
+    return NULL;
+
+  // empty needle matches everything
+  if (pattern->numUnits == 0)
+  {
+    if (matchLength)
+      *matchLength = 0;
+    return haystack;
+  }
+
+  const unsigned char* text = (const unsigned char*)haystack;
+
+  if (pattern->anchorLength > 0)
+  {
+    // leftmost match found so far
+    size_t bestFirst = haystackLength;
+    size_t bestLast  = 0;
+
+    size_t scan = 0;
+    const char* hit;
+    while ((hit = searchAVX2NoCase(haystack + scan, haystackLength - scan,
+                                   pattern->anchor, pattern->anchorLength)) != NULL)
+    {
+      size_t anchorPos = hit - haystack;
+      // no later anchor can produce a match starting before bestFirst
+      if (bestFirst != haystackLength && anchorPos >= bestFirst + pattern->maxPrefixBytes)
+        break;
+
+      size_t first = anchorPos;
+      size_t last  = anchorPos + pattern->anchorLength;
+      if (matchUtf8Backward(pattern, pattern->anchorFirst, text, &first) &&
+          matchUtf8Forward (pattern, pattern->anchorFirst + pattern->anchorLength, text, haystackLength, &last) &&
+          first < bestFirst)
+      {
+        bestFirst = first;
+        bestLast  = last;
+      }
+
+      scan = anchorPos + 1;
+    }
+
+    // needle not found in haystack
+    if (bestFirst == haystackLength)
+      return NULL;
+
+    if (matchLength)
+      *matchLength = bestLast - bestFirst;
+    return haystack + bestFirst;
+  }
+
+  // no ASCII in needle: check every position starting with a suitable byte
+  size_t pos;
+  for (pos = 0; pos < haystackLength; pos++)
+  {
+    if (!pattern->startBytes[text[pos]])
+      continue;
+
+    size_t last = pos;
+    if (matchUtf8Forward(pattern, 0, text, haystackLength, &last))
+    {
+      if (matchLength)
+        *matchLength = last - pos;
+      return haystack + pos;
+    }
+  }
+
+  // needle not found in haystack
+  return NULL;
+}
+
+
+// //////////////////////////////////////////////////////////
+
+
+/// base-2 logarithm of x > 0 with 16 fractional bits, integer only (works without libm and an FPU):
+/// exponent by the highest set bit, mantissa bit by bit by squaring
+static uint64_t log2Fixed(uint64_t x)
+{
+  // integer part
+  uint64_t result = 0;
+  uint64_t top    = x;
+  while (top >= 2)
+  {
+    top >>= 1;
+    result++;
+  }
+
+  // normalize to 1 <= mantissa < 2 with 31 fractional bits (x may have more significant bits than that)
+  uint64_t mantissa = result > 31 ? x >> (result - 31) : x << (31 - result);
+  result <<= 16;
+
+  // squaring doubles the logarithm: if mantissa^2 >= 2 then the next bit is set
+  uint64_t bit;
+  for (bit = (uint64_t)1 << 15; bit > 0; bit >>= 1)
+  {
+    mantissa = (mantissa * mantissa) >> 31;
+    if (mantissa >= (uint64_t)1 << 32)
+    {
+      mantissa >>= 1;
+      result   |= bit;
+    }
+  }
+  return result;
+}
+
+
+/// maximal suffix of needle w.r.t. the lexicographic order (or its reverse), returns start of the suffix minus 1,
+/// stores the period of the suffix (Crochemore-Perrin, see Charras/Lecroq "Handbook of Exact String Matching")
+static ptrdiff_t maximalSuffix(const unsigned char* needle, size_t needleLength, int reverse, size_t* period)
+{
+  ptrdiff_t suffix = -1;
+  ptrdiff_t j      = 0;
+  ptrdiff_t k      = 1;
+  ptrdiff_t p      = 1;
+  while (j + k < (ptrdiff_t)needleLength)
+  {
+    unsigned char a = needle[j + k];
+    unsigned char b = needle[suffix + k];
+    if (reverse ? a > b : a < b)
+    {
+      j += k;
+      k  = 1;
+      p  = j - suffix;
+    }
+    else if (a == b)
+    {
+      if (k != p)
+        k++;
+      else
+      {
+        j += p;
+        k  = 1;
+      }
+    }
+    else
+    {
+      suffix = j;
+      j      = suffix + 1;
+      k = p  = 1;
+    }
+  }
+
+  *period = (size_t)p;
+  return suffix;
+}
+
+
+/// compute period, critical factorization, byte histogram, rarest bytes, entropy and Boyer-Moore-Horspool's expected shift
+void analyzeNeedle(NeedleAnalysis* analysis, const char* needle, size_t needleLength)
+{
+  if (!analysis)
+    return;
+
+  memset(analysis, 0, sizeof(NeedleAnalysis));
+  analysis->rarestRank       = 256;
+  analysis->secondRarestRank = 256;
+  if (!needle || needleLength == 0)
+    return;
+
+  const unsigned char* bytes = (const unsigned char*)needle;
+
+  // histogram
+  size_t i;
+  for (i = 0; i < needleLength; i++)
+    analysis->histogram[bytes[i]]++;
+
+  const size_t AlphabetSize = 256;
+  uint64_t weightedLog = 0;
+  size_t c;
+  for (c = 0; c < AlphabetSize; c++)
+  {
+    if (analysis->histogram[c] == 0)
+      continue;
+    analysis->numDistinct++;
+
+    // Shannon entropy: -sum(p * log2(p)) = log2(n) - sum(count * log2(count)) / n
+    weightedLog += analysis->histogram[c] * log2Fixed(analysis->histogram[c]);
+
+    // two rarest distinct bytes
+    int rank = ByteFrequency[c];
+    if (rank < analysis->rarestRank)
+    {
+      analysis->secondRarest     = analysis->rarest;
+      analysis->secondRarestRank = analysis->rarestRank;
+      analysis->rarest           = (unsigned char)c;
+      analysis->rarestRank       = rank;
+    }
+    else if (rank < analysis->secondRarestRank)
+    {
+      analysis->secondRarest     = (unsigned char)c;
+      analysis->secondRarestRank = rank;
+    }
+  }
+
+  // convert from 16 to 8 fractional bits (rounded)
+  analysis->entropy = (unsigned int)((log2Fixed(needleLength) - weightedLog / needleLength + 128) >> 8);
+
+  // shortest period: needleLength minus the longest proper border (KMP's failure function)
+  size_t* border = (size_t*)malloc(needleLength * sizeof(size_t));
+  if (border)
+  {
+    border[0] = 0;
+    size_t length = 0;
+    for (i = 1; i < needleLength; i++)
+    {
+      while (length > 0 && bytes[i] != bytes[length])
+        length = border[length - 1];
+      if (bytes[i] == bytes[length])
+        length++;
+      border[i] = length;
+    }
+    analysis->period = needleLength - border[needleLength - 1];
+    free(border);
+  }
+  else
+    analysis->period = needleLength;
+
+  // critical factorization: the later of both maximal suffixes (as used by the Two-Way algorithm)
+  size_t periodForward, periodReverse;
+  ptrdiff_t forward = maximalSuffix(bytes, needleLength, 0, &periodForward);
+  ptrdiff_t reverse = maximalSuffix(bytes, needleLength, 1, &periodReverse);
+  if (forward > reverse)
+  {
+    analysis->criticalPosition = (size_t)(forward + 1);
+    analysis->localPeriod      = periodForward;
+  }
+  else
+  {
+    analysis->criticalPosition = (size_t)(reverse + 1);
+    analysis->localPeriod      = periodReverse;
+  }
+
+  // Boyer-Moore-Horspool's shift for each byte, weighted by its probability in text:
+  // Zipf's law applied to the built-in frequency ranks (the most frequent byte has rank 255 => weight 1/1)
+  size_t skip[256];
+  createSkipTable(skip, needle, needleLength - 1);
+  // weights with 24 fractional bits, totalWeight >= 256 * 2^16 keeps 16 bits when scaling it down (result rounded)
+  uint64_t weightedShift = 0;
+  uint64_t totalWeight   = 0;
+  for (c = 0; c < AlphabetSize; c++)
+  {
+    uint64_t weight = ((uint64_t)1 << 24) / (256 - ByteFrequency[c]);
+    weightedShift  += weight * skip[c];
+    totalWeight    += weight;
+  }
+  analysis->averageShift = (size_t)((weightedShift + (totalWeight >> 9)) / (totalWeight >> 8));
+}
+
+
+// //////////////////////////////////////////////////////////
+
+
+/// kernels for short needles, referenced by name in calibration profiles
+static const struct
+{
+  const char*    name;
+  SearchFunction function;
+} ShortKernels[] =
+{
+  { "native", searchNative },
+  { "swar",   searchSWAR   },
+  { "sse42",  searchSSE42  },
+  { "avx2",   searchAVX2   },
+  { "avx512", searchAVX512 }
+};
+
+
+/// same rule as mygrep used before: searchNative up to 16 bytes, else Boyer-Moore-Horspool
+/// (haystacks up to 256 bytes always searchNative, preprocessing would dominate, see ./benchmark --latency)
+void defaultSearchProfile(SearchProfile* profile)
+{
+  if (!profile)
+    return;
+
+  profile->smallHaystack = 256;
+  strcpy(profile->shortKernel, "native");
+  profile->longNeedle    = 16;
+  profile->rareByteRank  = -1;
+}
+
+
+/// read a profile written by saveSearchProfile, keys not found in the file keep their current value, returns 0 on failure
+int loadSearchProfile(SearchProfile* profile, const char* filename)
+{
+  if (!profile || !filename)
+    return 0;
+
+  FILE* file = fopen(filename, "r");
+  if (!file)
+    return 0;
+
+  char line[256];
+  while (fgets(line, sizeof(line), file))
+  {
+    // skip comments
+    if (line[0] == '#')
+      continue;
+
+    char key[64], value[64];
+    if (sscanf(line, "%63s %63s", key, value) != 2)
+      continue;
+
+    if      (strcmp(key, "smallHaystack") == 0)
+      profile->smallHaystack = (size_t)strtoul(value, NULL, 10);
+    else if (strcmp(key, "longNeedle")    == 0)
+      profile->longNeedle    = (size_t)strtoul(value, NULL, 10);
+    else if (strcmp(key, "rareByteRank")  == 0)
+      profile->rareByteRank  = atoi(value);
+    else if (strcmp(key, "shortKernel")   == 0 && strlen(value) < sizeof(profile->shortKernel))
+      strcpy(profile->shortKernel, value);
+  }
+
+  fclose(file);
+  return 1;
+}
+
+
+/// write a profile, returns 0 on failure
+int saveSearchProfile(const SearchProfile* profile, const char* filename)
+{
+  if (!profile || !filename)
+    return 0;
+
+  FILE* file = fopen(filename, "w");
+  if (!file)
+    return 0;
+
+  fprintf(file, "# search profile, created by ./benchmark --calibrate\n");
+  fprintf(file, "smallHaystack %lu\n", (unsigned long)profile->smallHaystack);
+  fprintf(file, "shortKernel %s\n",    profile->shortKernel);
+  fprintf(file, "longNeedle %lu\n",    (unsigned long)profile->longNeedle);
+  fprintf(file, "rareByteRank %d\n",   profile->rareByteRank);
+
+  return fclose(file) == 0;
+}
+
+
+/// rank of the needle's rarest byte according to the built-in frequency table (0 = rarest, 255 = most frequent)
+int rarestByteRank(const char* needle, size_t needleLength)
+{
+  int rarest = 255;
+  size_t i;
+  for (i = 0; i < needleLength; i++)
+    if (rarest > ByteFrequency[(unsigned char)needle[i]])
+      rarest = ByteFrequency[(unsigned char)needle[i]];
+  return rarest;
+}
+
+
+/// choose an algorithm based on a calibration profile (or the defaults if profile is NULL)
+/** - tiny haystacks: searchNative, nothing else pays off
+    - short needles: searchNativeRareByte if the needle contains a rare byte, else the fastest SIMD/SWAR kernel
+    - long needles: Boyer-Moore-Horspool, unless its expected shift isn't longer than a short needle **/
+SearchFunction selectSearchFunction(const SearchProfile* profile,
+                                    const char* needle, size_t needleLength, size_t haystackLength)
+{
+  SearchProfile defaults;
+  if (!profile)
+  {
+    defaultSearchProfile(&defaults);
+    profile = &defaults;
+  }
+
+  // no need to analyze the needle
+  if (haystackLength <= profile->smallHaystack || !needle)
+    return searchNative;
+
+  NeedleAnalysis analysis;
+  analyzeNeedle(&analysis, needle, needleLength);
+  return selectSearchFunctionFromAnalysis(profile, &analysis, needleLength, haystackLength);
+}
+
+
+/// same as selectSearchFunction, but the needle was already analyzed (cheap enough to be called for each haystack)
+SearchFunction selectSearchFunctionFromAnalysis(const SearchProfile* profile, const NeedleAnalysis* analysis,
+                                                size_t needleLength, size_t haystackLength)
+{
+  SearchProfile defaults;
+  if (!profile)
+  {
+    defaultSearchProfile(&defaults);
+    profile = &defaults;
+  }
+
+  if (haystackLength <= profile->smallHaystack || !analysis)
+    return searchNative;
+
+  // look up kernel by name
+  SearchFunction shortKernel = searchNative;
+  size_t k;
+  for (k = 0; k < sizeof(ShortKernels) / sizeof(ShortKernels[0]); k++)
+    if (strcmp(ShortKernels[k].name, profile->shortKernel) == 0)
+      shortKernel = ShortKernels[k].function;
+
+  if (needleLength <= profile->longNeedle)
+  {
+    // a rare byte is a good anchor for memchr()
+    if (analysis->rarestRank <= profile->rareByteRank)
+      return searchNativeRareByte;
+    return shortKernel;
+  }
+
+  // Boyer-Moore-Horspool wins only if it skips more than a short needle on average
+  // (its expected shift is a fixed-point number with 8 fractional bits)
+  if (analysis->averageShift / 256 <= profile->longNeedle)
+    return shortKernel;
+
+  return searchBoyerMooreHorspool;
+}
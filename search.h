@@ -10,6 +10,10 @@
 
 // all functions are declared similar to strstr
 
+/// all functions for non-text data share the same signature
+typedef const char* (*SearchFunction)(const char* haystack, size_t haystackLength,
+                                      const char* needle,   size_t needleLength);
+
 /// naive approach (for C strings)
 const char* searchSimpleString            (const char* haystack, const char* needle);
 /// naive approach (for non-text data)
@@ -27,12 +31,67 @@ const char* searchBoyerMooreHorspoolString(const char* haystack, const char* nee
 /// Boyer-Moore-Horspool algorithm (for non-text data)
 const char* searchBoyerMooreHorspool      (const char* haystack, size_t haystackLength,
                                            const char* needle,   size_t needleLength);
+/// Boyer-Moore-Horspool algorithm, ignoring ASCII case
+const char* searchBoyerMooreHorspoolNoCase(const char* haystack, size_t haystackLength,
+                                           const char* needle,   size_t needleLength);
+
+/// Quick Search algorithm by Daniel M. Sunday (for C strings)
+const char* searchQuickSearchString       (const char* haystack, const char* needle);
+/// Quick Search algorithm by Daniel M. Sunday (for non-text data)
+const char* searchQuickSearch             (const char* haystack, size_t haystackLength,
+                                           const char* needle,   size_t needleLength);
+
+/// Raita algorithm (for C strings)
+const char* searchRaitaString             (const char* haystack, const char* needle);
+/// Raita algorithm (for non-text data)
+const char* searchRaita                   (const char* haystack, size_t haystackLength,
+                                           const char* needle,   size_t needleLength);
+
+/// Boyer-Moore-Horspool with a skip table indexed by hashed 3-grams (for non-text data, small alphabets such as DNA)
+const char* searchHash3                   (const char* haystack, size_t haystackLength,
+                                           const char* needle,   size_t needleLength);
+/// Boyer-Moore-Horspool with a skip table indexed by hashed 5-grams (for non-text data, small alphabets such as DNA)
+const char* searchHash5                   (const char* haystack, size_t haystackLength,
+                                           const char* needle,   size_t needleLength);
+/// Boyer-Moore-Horspool with a skip table indexed by hashed 8-grams (for non-text data, small alphabets and long needles)
+const char* searchHash8                   (const char* haystack, size_t haystackLength,
+                                           const char* needle,   size_t needleLength);
+
+/// Boyer-Moore algorithm (for C strings)
+const char* searchBoyerMooreString        (const char* haystack, const char* needle);
+/// Boyer-Moore algorithm with bad-character and good-suffix rule and Galil's optimization (for non-text data)
+const char* searchBoyerMoore              (const char* haystack, size_t haystackLength,
+                                           const char* needle,   size_t needleLength);
 
 /// Bitap algorithm / Baeza-Yates-Gonnet algorithm (for C strings)
 const char* searchBitapString             (const char* haystack, const char* needle);
 /// Bitap algorithm / Baeza-Yates-Gonnet algorithm (for non-text data)
 const char* searchBitap                   (const char* haystack, size_t haystackLength,
                                            const char* needle,   size_t needleLength);
+/// Bitap algorithm, ignoring ASCII case
+const char* searchBitapNoCase             (const char* haystack, size_t haystackLength,
+                                           const char* needle,   size_t needleLength);
+/// Bitap needle with wildcards (?), sets ([abc], [a-z], [^...]), escapes (\) and case folding ((?i) and (?-i)), at most 64 positions
+typedef struct BitapPattern BitapPattern;
+/// compile a Bitap pattern, returns NULL if invalid, longer than 64 positions or out of memory
+BitapPattern* compileBitapPattern         (const char* pattern, size_t patternLength, int ignoreCase);
+/// release memory of a compiled Bitap pattern
+void        freeBitapPattern              (BitapPattern* pattern);
+/// Bitap algorithm for a compiled pattern, stores length of the match in matchLength (if not NULL)
+const char* searchBitapPattern            (const BitapPattern* pattern,
+                                           const char* haystack, size_t haystackLength, size_t* matchLength);
+
+/// Backward Nondeterministic DAWG Matching (for C strings)
+const char* searchBackwardNondeterministicDawgString(const char* haystack, const char* needle);
+/// Backward Nondeterministic DAWG Matching (for non-text data)
+const char* searchBackwardNondeterministicDawg      (const char* haystack, size_t haystackLength,
+                                                     const char* needle,   size_t needleLength);
+
+/// Backward Oracle Matching (for C strings)
+const char* searchBackwardOracleMatchingString      (const char* haystack, const char* needle);
+/// Backward Oracle Matching (for non-text data)
+const char* searchBackwardOracleMatching            (const char* haystack, size_t haystackLength,
+                                                     const char* needle,   size_t needleLength);
 
 /// Rabin-Karp algorithm (for C strings)
 const char* searchRabinKarpString         (const char *haystack, const char *needle);
@@ -40,6 +99,117 @@ const char* searchRabinKarpString         (const char *haystack, const char *nee
 const char* searchRabinKarp               (const char* haystack, size_t haystackLength,
                                            const char* needle,   size_t needleLength);
 
+/// Rabin-Karp algorithm with a 64-bit polynomial rolling hash (for C strings)
+const char* searchRabinKarp64String       (const char* haystack, const char* needle);
+/// Rabin-Karp algorithm with a 64-bit polynomial rolling hash (for non-text data)
+const char* searchRabinKarp64             (const char* haystack, size_t haystackLength,
+                                           const char* needle,   size_t needleLength);
+
+/// set of needles for searchRabinKarpSet, needles are grouped by length (best performance if all have the same length)
+typedef struct RabinKarpSet RabinKarpSet;
+/// create a set of needles, duplicates and empty needles are ignored, returns NULL if out of memory
+RabinKarpSet* createRabinKarpSet          (const char* const* needles, const size_t* needleLengths, size_t numNeedles);
+/// release memory of a needle set
+void        freeRabinKarpSet              (RabinKarpSet* set);
+/// Rabin-Karp algorithm for many needles at once (for non-text data), stores length of the matching needle in matchLength (if not NULL)
+const char* searchRabinKarpSet            (const RabinKarpSet* set,
+                                           const char* haystack, size_t haystackLength, size_t* matchLength);
+
 /// super-fast for short strings (less than about 8 bytes), else use searchSimple or searchBoyerMooreHorspool
 const char* searchNative                  (const char* haystack, size_t haystackLength,
                                            const char* needle,   size_t needleLength);
+
+/// SWAR: first and last byte of needle compared at 8 positions per step with 64 bit integer arithmetic, portable (no intrinsics, no memchr)
+const char* searchSWAR                    (const char* haystack, size_t haystackLength,
+                                           const char* needle,   size_t needleLength);
+/// SWAR, ignoring ASCII case
+const char* searchSWARNoCase              (const char* haystack, size_t haystackLength,
+                                           const char* needle,   size_t needleLength);
+
+/// SSE4.2 string instructions (PCMPESTRI), best for needles up to 16 bytes, falls back to searchNative if CPU lacks SSE4.2
+const char* searchSSE42                   (const char* haystack, size_t haystackLength,
+                                           const char* needle,   size_t needleLength);
+/// AVX2 filter for needle's first and last byte (32 positions at once), falls back to searchNative if CPU lacks AVX2
+const char* searchAVX2                    (const char* haystack, size_t haystackLength,
+                                           const char* needle,   size_t needleLength);
+/// AVX2 filter, ignoring ASCII case (letters are ORed with 0x20), falls back to searchSWARNoCase if CPU lacks AVX2
+const char* searchAVX2NoCase              (const char* haystack, size_t haystackLength,
+                                           const char* needle,   size_t needleLength);
+/// AVX-512BW filter for needle's first and last byte (64 positions at once), falls back to searchAVX2 if CPU lacks AVX-512BW
+const char* searchAVX512                  (const char* haystack, size_t haystackLength,
+                                           const char* needle,   size_t needleLength);
+/// count newline bytes (uses AVX-512BW if available)
+size_t      countNewlines                 (const char* data, size_t length);
+
+/// like searchNative, but memchr() looks for the rarest byte of needle (according to a built-in frequency table)
+const char* searchNativeRareByte          (const char* haystack, size_t haystackLength,
+                                           const char* needle,   size_t needleLength);
+/// like searchNativeRareByte, but bytes are ranked by a custom table (0 = rarest, 255 = most frequent), see trainByteFrequency
+const char* searchNativeRareByteTable     (const char* haystack, size_t haystackLength,
+                                           const char* needle,   size_t needleLength,
+                                           const unsigned char frequency[256]);
+/// count bytes of a sample (e.g. the first few kilobytes of the haystack) and convert to a table for searchNativeRareByteTable
+void        trainByteFrequency            (unsigned char frequency[256], const char* sample, size_t sampleLength);
+
+/// case-insensitive UTF-8 needle (ASCII, Latin-1, Latin Extended-A, Greek, Cyrillic, ß = ẞ = ss), see searchUtf8Pattern
+typedef struct Utf8Pattern Utf8Pattern;
+/// compile needle into all its case variants (invalid UTF-8 bytes are matched literally), returns NULL if out of memory
+Utf8Pattern* compileUtf8Pattern           (const char* needle, size_t needleLength);
+/// release memory of a compiled needle
+void        freeUtf8Pattern               (Utf8Pattern* pattern);
+/// case-insensitive search without decoding the haystack, stores length of the match in matchLength (if not NULL)
+const char* searchUtf8Pattern             (const Utf8Pattern* pattern,
+                                           const char* haystack, size_t haystackLength, size_t* matchLength);
+
+/// structure of a needle, see analyzeNeedle
+typedef struct
+{
+  /// shortest period (needleLength if needle isn't periodic)
+  size_t period;
+  /// critical factorization: needle = needle[0, criticalPosition) + needle[criticalPosition, needleLength), as used by Two-Way
+  size_t criticalPosition;
+  /// local period at the critical position
+  size_t localPeriod;
+  /// how often each byte occurs
+  size_t histogram[256];
+  /// number of distinct bytes
+  size_t numDistinct;
+  /// Shannon entropy in 1/256 bits per byte (fixed-point, search.c doesn't use floating-point math)
+  unsigned int entropy;
+  /// the two rarest distinct bytes according to the built-in frequency table (rank 0 = rarest, 256 = none)
+  unsigned char rarest;
+  int           rarestRank;
+  unsigned char secondRarest;
+  int           secondRarestRank;
+  /// expected shift of Boyer-Moore-Horspool if the haystack's bytes follow the built-in frequency table (Zipf's law), in 1/256 bytes
+  size_t averageShift;
+} NeedleAnalysis;
+/// compute period, critical factorization, byte histogram, rarest bytes, entropy and Boyer-Moore-Horspool's expected shift
+void        analyzeNeedle                 (NeedleAnalysis* analysis, const char* needle, size_t needleLength);
+
+/// crossover points for selectSearchFunction, measured on the target machine by ./benchmark --calibrate
+typedef struct
+{
+  /// haystacks up to this size are always scanned by searchNative
+  size_t smallHaystack;
+  /// kernel for short needles: "native", "swar", "sse42", "avx2" or "avx512"
+  char   shortKernel[16];
+  /// needles up to this length use shortKernel (or searchNativeRareByte), longer ones Boyer-Moore-Horspool
+  size_t longNeedle;
+  /// searchNativeRareByte if the rarest byte of a short needle has at most this rank (0 = rarest, -1 = never)
+  int    rareByteRank;
+} SearchProfile;
+/// same rule as mygrep used before calibration existed: searchNative up to 16 bytes, else Boyer-Moore-Horspool, tiny haystacks (up to 256 bytes) always searchNative
+void        defaultSearchProfile          (SearchProfile* profile);
+/// read a profile, keys missing in the file keep their current value, returns 0 on failure
+int         loadSearchProfile             (SearchProfile* profile, const char* filename);
+/// write a profile, returns 0 on failure
+int         saveSearchProfile             (const SearchProfile* profile, const char* filename);
+/// rank of the needle's rarest byte according to the built-in frequency table of searchNativeRareByte (0 = rarest)
+int         rarestByteRank                (const char* needle, size_t needleLength);
+/// choose an algorithm based on needle length, Boyer-Moore-Horspool's expected shift, byte rarity and haystack size (profile may be NULL)
+SearchFunction selectSearchFunction       (const SearchProfile* profile,
+                                           const char* needle, size_t needleLength, size_t haystackLength);
+/// same as selectSearchFunction, but the needle was already analyzed (cheap enough to be called for each haystack)
+SearchFunction selectSearchFunctionFromAnalysis(const SearchProfile* profile, const NeedleAnalysis* analysis,
+                                                size_t needleLength, size_t haystackLength);
@@ -0,0 +1,553 @@
+// //////////////////////////////////////////////////////////
+// search.hpp
+// Copyright (c) 2014,2019 Stephan Brumme. All rights reserved.
+// see http://create.stephan-brumme.com/disclaimer.html
+//
+
+// header-only C++ wrapper, compiles with: g++ -Wall -std=c++17 (or -std=c++20, runtime needles require search.c)
+
+#pragma once
+
+extern "C"
+{
+#include "search.h"
+}
+
+#include <cstddef>     // size_t
+#include <cstdint>     // uint64_t
+#include <cstring>     // memchr
+#include <iterator>    // iterator_traits
+#include <optional>
+#include <string>
+#include <string_view>
+#include <type_traits> // is_base_of
+#include <utility>     // index_sequence, pair
+#include <vector>
+
+namespace search
+{
+  /// needle known at compile time: skip table, failure table and bit masks are computed by the compiler
+  /** static constexpr search::StaticNeedle marker("ERROR:");
+      const char* hit = marker.search(haystack, haystackLength); **/
+  template <size_t Length>
+  struct StaticNeedle
+  {
+    static_assert(Length > 0, "needle must not be empty");
+
+    /// needles up to this length are compared with fully unrolled code
+    static constexpr size_t MaxUnrolled = 16;
+    /// Bitap needs one bit per byte of the needle
+    static constexpr size_t MaxBitWidth = 64;
+
+    /// the needle (without its terminating zero)
+    char     bytes[Length]      = {};
+    /// Boyer-Moore-Horspool: distance of each byte's right-most occurrence to the last position
+    size_t   skip[256]          = {};
+    /// Knuth-Morris-Pratt: failure table, one more entry than the needle's length
+    int      border[Length + 1] = {};
+    /// Bitap: bit i of masks[c] is set if needle[i] == c (only the first 64 bytes)
+    uint64_t masks[256]         = {};
+
+    /// all tables are filled at compile time if the object is constexpr
+    constexpr StaticNeedle(const char (&literal)[Length + 1])
+    {
+      for (size_t i = 0; i < Length; i++)
+        bytes[i] = literal[i];
+
+      // same as createSkipTable() in search.c
+      for (size_t i = 0; i < 256; i++)
+        skip[i] = Length;
+      for (size_t i = 0; i + 1 < Length; i++)
+        skip[(unsigned char)bytes[i]] = Length - 1 - i;
+
+      // same as searchKnuthMorrisPratt()
+      border[0] = -1;
+      for (size_t i = 0; i < Length; i++)
+      {
+        border[i + 1] = border[i] + 1;
+        while (border[i + 1] > 0 && bytes[i] != bytes[border[i + 1] - 1])
+          border[i + 1] = border[border[i + 1] - 1] + 1;
+      }
+
+      // same as createBitMasks()
+      for (size_t i = 0; i < Length && i < MaxBitWidth; i++)
+        masks[(unsigned char)bytes[i]] |= (uint64_t)1 << i;
+    }
+
+    /// number of bytes
+    static constexpr size_t size() { return Length; }
+
+    /// compare haystack[Index...] to the needle, unrolled by the compiler
+    template <size_t... Index>
+    bool equalUnrolled(const char* haystack, std::index_sequence<Index...>) const
+    {
+      return ((haystack[Index] == bytes[Index]) && ...);
+    }
+
+    /// true if haystack starts with the needle
+    bool equal(const char* haystack) const
+    {
+      if constexpr (Length <= MaxUnrolled)
+        return equalUnrolled(haystack, std::make_index_sequence<Length>());
+
+      // long needles: plain loop
+      for (size_t i = 0; i < Length; i++)
+        if (haystack[i] != bytes[i])
+          return false;
+      return true;
+    }
+
+    /// memchr for the first byte, then an unrolled comparison (similar to searchNative)
+    const char* searchNative(const char* haystack, size_t haystackLength) const
+    {
+      // detect invalid input
+      if (!haystack || haystackLength < Length)
+        return nullptr;
+
+      // shorter code for just one character
+      if constexpr (Length == 1)
+        return (const char*)memchr(haystack, bytes[0], haystackLength);
+
+      // points to the last position where a match may begin
+      const char* last = haystack + haystackLength - Length;
+      while ((haystack = (const char*)memchr(haystack, bytes[0], last - haystack + 1)) != nullptr)
+      {
+        // does last byte match, too ? okay, perform full comparison
+        if (haystack[Length - 1] == bytes[Length - 1] && equal(haystack))
+          return haystack;
+
+        if (haystack == last)
+          return nullptr;
+        haystack++;
+      }
+
+      // needle not found in haystack
+      return nullptr;
+    }
+
+    /// Knuth-Morris-Pratt algorithm with a precomputed failure table
+    const char* searchKnuthMorrisPratt(const char* haystack, size_t haystackLength) const
+    {
+      // detect invalid input
+      if (!haystack || haystackLength < Length)
+        return nullptr;
+
+      const char* haystackEnd = haystack + haystackLength;
+      int shift = 0;
+      while (haystack != haystackEnd)
+      {
+        // look for a matching character
+        while (shift >= 0 && *haystack != bytes[shift])
+          shift = border[shift];
+
+        // single step forward in needle and haystack
+        haystack++;
+        shift++;
+
+        // reached end of needle => hit
+        if ((size_t)shift == Length)
+          return haystack - shift;
+      }
+
+      // needle not found in haystack
+      return nullptr;
+    }
+
+    /// Boyer-Moore-Horspool algorithm with a precomputed skip table
+    const char* searchBoyerMooreHorspool(const char* haystack, size_t haystackLength) const
+    {
+      // detect invalid input
+      if (!haystack || haystackLength < Length)
+        return nullptr;
+
+      const size_t lastPos = Length - 1;
+      while (haystackLength >= Length)
+      {
+        // compare last byte first, then the whole needle
+        unsigned char marker = (unsigned char)haystack[lastPos];
+        if (marker == (unsigned char)bytes[lastPos] && equal(haystack))
+          return haystack;
+
+        // no match, jump ahead
+        haystackLength -= skip[marker];
+        haystack       += skip[marker];
+      }
+
+      // needle not found in haystack
+      return nullptr;
+    }
+
+    /// Bitap algorithm with precomputed bit masks (needles up to 64 bytes)
+    const char* searchBitap(const char* haystack, size_t haystackLength) const
+    {
+      static_assert(Length <= MaxBitWidth, "Bitap supports only needles up to 64 bytes");
+
+      // detect invalid input
+      if (!haystack || haystackLength < Length)
+        return nullptr;
+
+      const char* haystackEnd = haystack + haystackLength;
+
+      // bit i of state is set if the last i+1 bytes match the first i+1 bytes of needle ("Shift-And")
+      uint64_t state = 0;
+      const uint64_t FullMatch = (uint64_t)1 << (Length - 1);
+      while (haystack != haystackEnd)
+      {
+        state  = (state << 1) | 1;
+        state &= masks[(unsigned char)*haystack];
+
+        // if a set bit "bubbled up" we have a match
+        if (state & FullMatch)
+          return (haystack - Length) + 1;
+
+        haystack++;
+      }
+
+      // needle not found in haystack
+      return nullptr;
+    }
+
+    /// short needles: memchr plus unrolled comparison, long needles: Boyer-Moore-Horspool
+    const char* search(const char* haystack, size_t haystackLength) const
+    {
+      if constexpr (Length <= MaxUnrolled)
+        return searchNative(haystack, haystackLength);
+      else
+        return searchBoyerMooreHorspool(haystack, haystackLength);
+    }
+
+    /// same as above, for string_view
+    const char* search(std::string_view haystack) const
+    {
+      return search(haystack.data(), haystack.size());
+    }
+  };
+
+  /// deduce the needle's length from a string literal (excluding its terminating zero)
+  template <size_t LiteralLength>
+  StaticNeedle(const char (&literal)[LiteralLength]) -> StaticNeedle<LiteralLength - 1>;
+
+
+#if __cplusplus >= 202002L
+  /// C++20: the literal is a template argument, e.g. search::find<"ERROR:">(haystack, haystackLength)
+  template <StaticNeedle Needle>
+  const char* find(const char* haystack, size_t haystackLength)
+  {
+    return Needle.search(haystack, haystackLength);
+  }
+
+  /// C++20: same as above, for string_view
+  template <StaticNeedle Needle>
+  const char* find(std::string_view haystack)
+  {
+    return Needle.search(haystack.data(), haystack.size());
+  }
+#endif
+
+
+  /// needle known only at runtime: call any algorithm of search.c, e.g. search::find<searchBoyerMooreHorspool>(haystack, needle)
+  template <SearchFunction Algorithm = ::searchNative>
+  const char* find(std::string_view haystack, std::string_view needle)
+  {
+    return Algorithm(haystack.data(), haystack.size(), needle.data(), needle.size());
+  }
+
+
+  // //////////////////////////////////////////////////////////
+  // searchers for std::search (C++17):
+  // auto hit = std::search(text.begin(), text.end(), search::BoyerMooreHorspoolSearcher(needle.begin(), needle.end()));
+  // all tables are built by the constructor, operator() is const and doesn't modify anything (thread-safe)
+  // iterators must point to contiguous bytes (const char*, std::string, std::string_view, std::vector<char>, ...)
+
+  /// common part of all searchers: keeps a copy of the needle, converts iterators to pointers and back
+  template <typename Derived>
+  class SearcherBase
+  {
+  public:
+    /// find needle in [first, last), returns [last, last) if not found
+    template <typename RandomAccessIterator>
+    std::pair<RandomAccessIterator, RandomAccessIterator> operator()(RandomAccessIterator first, RandomAccessIterator last) const
+    {
+      static_assert(std::is_base_of<std::random_access_iterator_tag,
+                                    typename std::iterator_traits<RandomAccessIterator>::iterator_category>::value,
+                    "searchers require random access iterators");
+      static_assert(sizeof(typename std::iterator_traits<RandomAccessIterator>::value_type) == 1,
+                    "searchers require byte-sized elements");
+
+      // empty needle matches everything (same as std::search)
+      if (needle.empty())
+        return { first, first };
+      if (first == last)
+        return { last, last };
+
+      const char* haystack = reinterpret_cast<const char*>(&*first);
+      size_t haystackLength = last - first;
+      const char* hit = static_cast<const Derived*>(this)->find(haystack, haystackLength);
+      if (!hit)
+        return { last, last };
+
+      RandomAccessIterator begin = first + (hit - haystack);
+      return { begin, begin + needle.size() };
+    }
+
+    /// same as above, for string_view, returns std::string_view::npos if not found
+    size_t operator()(std::string_view haystack) const
+    {
+      const char* hit = needle.empty() ? haystack.data() :
+                        static_cast<const Derived*>(this)->find(haystack.data(), haystack.size());
+      return hit ? size_t(hit - haystack.data()) : std::string_view::npos;
+    }
+
+  protected:
+    template <typename ForwardIterator>
+    SearcherBase(ForwardIterator first, ForwardIterator last)
+    : needle(first, last)
+    {}
+
+    /// copy of the needle, no dangling iterators
+    std::string needle;
+  };
+
+
+  /// searcher for functions without preprocessing, such as searchNative, searchAVX2 or searchNativeRareByte
+  template <SearchFunction Algorithm>
+  class Searcher : public SearcherBase<Searcher<Algorithm>>
+  {
+  public:
+    template <typename ForwardIterator>
+    Searcher(ForwardIterator first, ForwardIterator last)
+    : SearcherBase<Searcher<Algorithm>>(first, last)
+    {}
+    explicit Searcher(std::string_view needle)
+    : Searcher(needle.begin(), needle.end())
+    {}
+
+    /// run the C function
+    const char* find(const char* haystack, size_t haystackLength) const
+    {
+      return Algorithm(haystack, haystackLength, this->needle.data(), this->needle.size());
+    }
+  };
+
+  /// memchr/memcmp
+  using NativeSearcher   = Searcher<::searchNative>;
+  /// memchr/memcmp anchored on the needle's rarest byte
+  using RareByteSearcher = Searcher<::searchNativeRareByte>;
+  /// SWAR first/last byte filter
+  using SWARSearcher     = Searcher<::searchSWAR>;
+  /// SSE4.2 PCMPESTRI (falls back to searchNative)
+  using SSE42Searcher    = Searcher<::searchSSE42>;
+  /// AVX2 first/last byte filter (falls back to searchNative)
+  using AVX2Searcher     = Searcher<::searchAVX2>;
+  /// AVX-512BW first/last byte filter (falls back to searchAVX2)
+  using AVX512Searcher   = Searcher<::searchAVX512>;
+
+
+  /// Knuth-Morris-Pratt algorithm, failure table built once
+  class KnuthMorrisPrattSearcher : public SearcherBase<KnuthMorrisPrattSearcher>
+  {
+  public:
+    template <typename ForwardIterator>
+    KnuthMorrisPrattSearcher(ForwardIterator first, ForwardIterator last)
+    : SearcherBase(first, last),
+      border(needle.size() + 1)
+    {
+      // same as searchKnuthMorrisPratt()
+      border[0] = -1;
+      for (size_t i = 0; i < needle.size(); i++)
+      {
+        border[i + 1] = border[i] + 1;
+        while (border[i + 1] > 0 && needle[i] != needle[border[i + 1] - 1])
+          border[i + 1] = border[border[i + 1] - 1] + 1;
+      }
+    }
+    explicit KnuthMorrisPrattSearcher(std::string_view needle)
+    : KnuthMorrisPrattSearcher(needle.begin(), needle.end())
+    {}
+
+    /// scan haystack
+    const char* find(const char* haystack, size_t haystackLength) const
+    {
+      if (!haystack || haystackLength < needle.size())
+        return nullptr;
+
+      const char* haystackEnd = haystack + haystackLength;
+      int shift = 0;
+      while (haystack != haystackEnd)
+      {
+        // look for a matching character
+        while (shift >= 0 && *haystack != needle[shift])
+          shift = border[shift];
+
+        // single step forward in needle and haystack
+        haystack++;
+        shift++;
+
+        // reached end of needle => hit
+        if ((size_t)shift == needle.size())
+          return haystack - shift;
+      }
+
+      // needle not found in haystack
+      return nullptr;
+    }
+
+  private:
+    /// failure table, one more entry than the needle's length
+    std::vector<int> border;
+  };
+
+
+  /// Boyer-Moore-Horspool algorithm, skip table built once (a plain array instead of std::unordered_map)
+  class BoyerMooreHorspoolSearcher : public SearcherBase<BoyerMooreHorspoolSearcher>
+  {
+  public:
+    template <typename ForwardIterator>
+    BoyerMooreHorspoolSearcher(ForwardIterator first, ForwardIterator last)
+    : SearcherBase(first, last)
+    {
+      // same as createSkipTable() in search.c
+      for (size_t i = 0; i < 256; i++)
+        skip[i] = needle.size();
+      for (size_t i = 0; i + 1 < needle.size(); i++)
+        skip[(unsigned char)needle[i]] = needle.size() - 1 - i;
+    }
+    explicit BoyerMooreHorspoolSearcher(std::string_view needle)
+    : BoyerMooreHorspoolSearcher(needle.begin(), needle.end())
+    {}
+
+    /// scan haystack
+    const char* find(const char* haystack, size_t haystackLength) const
+    {
+      const size_t needleLength = needle.size();
+      if (!haystack || haystackLength < needleLength)
+        return nullptr;
+
+      const char* bytes   = needle.data();
+      const size_t lastPos = needleLength - 1;
+      while (haystackLength >= needleLength)
+      {
+        // all characters match ?
+        size_t i;
+        for (i = lastPos; haystack[i] == bytes[i]; i--)
+          if (i == 0)
+            return haystack;
+
+        // no match, jump ahead
+        unsigned char marker = (unsigned char)haystack[lastPos];
+        haystackLength -= skip[marker];
+        haystack       += skip[marker];
+      }
+
+      // needle not found in haystack
+      return nullptr;
+    }
+
+  private:
+    /// distance of each byte's right-most occurrence to the last position
+    size_t skip[256];
+  };
+
+
+  /// Bitap algorithm, bit masks built once (needles longer than 64 bytes use searchNative)
+  class BitapSearcher : public SearcherBase<BitapSearcher>
+  {
+  public:
+    template <typename ForwardIterator>
+    BitapSearcher(ForwardIterator first, ForwardIterator last)
+    : SearcherBase(first, last),
+      masks()
+    {
+      // same as createBitMasks()
+      if (needle.size() <= MaxBitWidth)
+        for (size_t i = 0; i < needle.size(); i++)
+          masks[(unsigned char)needle[i]] |= (uint64_t)1 << i;
+    }
+    explicit BitapSearcher(std::string_view needle)
+    : BitapSearcher(needle.begin(), needle.end())
+    {}
+
+    /// scan haystack
+    const char* find(const char* haystack, size_t haystackLength) const
+    {
+      const size_t needleLength = needle.size();
+      if (!haystack || haystackLength < needleLength)
+        return nullptr;
+      if (needleLength > MaxBitWidth)
+        return ::searchNative(haystack, haystackLength, needle.data(), needleLength);
+
+      const char* haystackEnd = haystack + haystackLength;
+
+      // bit i of state is set if the last i+1 bytes match the first i+1 bytes of needle ("Shift-And")
+      uint64_t state = 0;
+      const uint64_t FullMatch = (uint64_t)1 << (needleLength - 1);
+      while (haystack != haystackEnd)
+      {
+        state  = (state << 1) | 1;
+        state &= masks[(unsigned char)*haystack];
+
+        // if a set bit "bubbled up" we have a match
+        if (state & FullMatch)
+          return (haystack - needleLength) + 1;
+
+        haystack++;
+      }
+
+      // needle not found in haystack
+      return nullptr;
+    }
+
+  private:
+    static constexpr size_t MaxBitWidth = 64;
+    /// bit i of masks[c] is set if needle[i] == c
+    uint64_t masks[256];
+  };
+
+
+  /// algorithm chosen once by selectSearchFunction (profile may be NULL, see benchmark --calibrate)
+  class SelectedSearcher : public SearcherBase<SelectedSearcher>
+  {
+  public:
+    template <typename ForwardIterator>
+    SelectedSearcher(ForwardIterator first, ForwardIterator last, const SearchProfile* profile = nullptr)
+    : SearcherBase(first, last),
+      // assume a large haystack, small ones are handled in find()
+      function(::selectSearchFunction(profile, needle.data(), needle.size(), (size_t)-1)),
+      smallHaystack(0)
+    {
+      // skip table only needed by Boyer-Moore-Horspool
+      if (function == ::searchBoyerMooreHorspool)
+        longNeedle.emplace(needle);
+
+      SearchProfile defaults;
+      if (!profile)
+      {
+        ::defaultSearchProfile(&defaults);
+        profile = &defaults;
+      }
+      smallHaystack = profile->smallHaystack;
+    }
+    explicit SelectedSearcher(std::string_view needle, const SearchProfile* profile = nullptr)
+    : SelectedSearcher(needle.begin(), needle.end(), profile)
+    {}
+
+    /// scan haystack
+    const char* find(const char* haystack, size_t haystackLength) const
+    {
+      if (haystackLength <= smallHaystack)
+        return ::searchNative(haystack, haystackLength, needle.data(), needle.size());
+      // use the precomputed skip table instead of building a new one each time
+      if (longNeedle)
+        return longNeedle->find(haystack, haystackLength);
+      return function(haystack, haystackLength, needle.data(), needle.size());
+    }
+
+  private:
+    /// only exists if selectSearchFunction returned searchBoyerMooreHorspool
+    std::optional<BoyerMooreHorspoolSearcher> longNeedle;
+    /// chosen algorithm
+    SearchFunction function;
+    /// haystacks up to this size are scanned by searchNative
+    size_t smallHaystack;
+  };
+}
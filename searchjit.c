@@ -0,0 +1,346 @@
+// //////////////////////////////////////////////////////////
+// searchjit.c
+// Copyright (c) 2014,2019 Stephan Brumme. All rights reserved.
+// see http://create.stephan-brumme.com/disclaimer.html
+//
+
+// compiles with: gcc -Wall -std=c99 (requires search.c)
+
+// mmap() and MAP_ANONYMOUS aren't part of C99
+#ifndef _DEFAULT_SOURCE
+#define _DEFAULT_SOURCE
+#endif
+
+#include "searchjit.h"
+#include "search.h"
+
+#include <string.h> // memcpy
+#include <stdlib.h> // malloc / free
+#include <stdint.h> // uint64_t
+
+// only x86-64 with System V calling convention (haystack in rdi, number of blocks in rsi, result in rax)
+#if defined(__x86_64__) && !defined(_WIN32) && !defined(SEARCH_NO_JIT) && !defined(SEARCH_NO_SIMD)
+#define SEARCH_JIT
+#include <sys/mman.h> // mmap / mprotect / munmap
+#ifndef MAP_ANONYMOUS
+#define MAP_ANONYMOUS MAP_ANON
+#endif
+#endif
+
+
+/// generated code: scans numBlocks blocks of 16 possible match positions each, returns NULL if not found
+typedef const char* (*JitFunction)(const char* haystack, size_t numBlocks);
+
+/// needle-specific search code
+struct JitSearch
+{
+  char*       needle;
+  size_t      needleLength;
+  /// NULL if no code was generated
+  JitFunction function;
+  /// executable memory
+  void*       code;
+  size_t      codeSize;
+};
+
+/// each block covers 16 positions (one SSE2 register)
+static const size_t JitBlockSize = 16;
+
+
+#ifdef SEARCH_JIT
+
+/// longer needles aren't worth it (and would need lots of code)
+static const size_t JitMaxNeedle = 256;
+
+/// write machine code into a buffer
+typedef struct
+{
+  unsigned char* code;
+  size_t         size;
+} Emitter;
+
+static void emitBytes(Emitter* emitter, const unsigned char* bytes, size_t numBytes)
+{
+  memcpy(emitter->code + emitter->size, bytes, numBytes);
+  emitter->size += numBytes;
+}
+
+static void emitByte(Emitter* emitter, unsigned char byte)
+{
+  emitter->code[emitter->size++] = byte;
+}
+
+/// little endian
+static void emitValue(Emitter* emitter, uint64_t value, size_t numBytes)
+{
+  size_t i;
+  for (i = 0; i < numBytes; i++)
+    emitByte(emitter, (unsigned char)(value >> (8 * i)));
+}
+
+/// jump with 32 bit displacement to a known target (backwards)
+static void emitJump(Emitter* emitter, const unsigned char* opcode, size_t opcodeSize, size_t target)
+{
+  emitBytes(emitter, opcode, opcodeSize);
+  emitValue(emitter, (uint64_t)(target - (emitter->size + 4)), 4);
+}
+
+/// jump with 32 bit displacement to an unknown target (forwards), returns position of the displacement
+static size_t emitForwardJump(Emitter* emitter, const unsigned char* opcode, size_t opcodeSize)
+{
+  emitBytes(emitter, opcode, opcodeSize);
+  size_t fixup = emitter->size;
+  emitValue(emitter, 0, 4);
+  return fixup;
+}
+
+/// set displacement of a forward jump to the current position
+static void patchJump(Emitter* emitter, size_t fixup)
+{
+  uint64_t distance = emitter->size - (fixup + 4);
+  size_t i;
+  for (i = 0; i < 4; i++)
+    emitter->code[fixup + i] = (unsigned char)(distance >> (8 * i));
+}
+
+/// rank of a single byte in the built-in frequency table (0 = rarest)
+static int byteRank(char byte)
+{
+  return rarestByteRank(&byte, 1);
+}
+
+/// a part of the needle verified by a single compare
+typedef struct
+{
+  size_t offset;
+  size_t size;
+  int    rank;
+} JitChunk;
+
+/// generate x86-64 code, returns its size or 0 if failed
+static size_t generateCode(unsigned char* code, const char* needle, size_t needleLength)
+{
+  // x86 opcodes
+  static const unsigned char Jz   [] = { 0x0F, 0x84 };
+  static const unsigned char Jnz  [] = { 0x0F, 0x85 };
+  static const unsigned char Jmp  [] = { 0xE9 };
+
+  Emitter emitter = { code, 0 };
+  Emitter* e = &emitter;
+
+  // two anchors: positions of the rarest byte and of the second rarest byte (or any other position)
+  size_t first = 0, second = needleLength - 1;
+  size_t i;
+  for (i = 1; i < needleLength; i++)
+    if (byteRank(needle[i]) < byteRank(needle[first]))
+      first = i;
+  int secondRank = 256;
+  for (i = 0; i < needleLength; i++)
+    if (needle[i] != needle[first] && byteRank(needle[i]) < secondRank)
+    {
+      second     = i;
+      secondRank = byteRank(needle[i]);
+    }
+  if (second == first)
+    second = first == 0 ? needleLength - 1 : 0;
+
+  // split needle into chunks of 8, 4 or 2 bytes (the last one may overlap its predecessor)
+  size_t chunkSize = needleLength >= 8 ? 8 : needleLength >= 4 ? 4 : 2;
+  JitChunk chunks[256 / 8 + 1];
+  size_t numChunks = 0;
+  size_t offset;
+  for (offset = 0; offset < needleLength; offset += chunkSize)
+  {
+    JitChunk* chunk = &chunks[numChunks++];
+    chunk->offset = offset + chunkSize <= needleLength ? offset : needleLength - chunkSize;
+    chunk->size   = chunkSize;
+    chunk->rank   = rarestByteRank(needle + chunk->offset, chunkSize);
+  }
+  // rarest chunks first, because they most likely reject a false candidate (insertion sort, stable)
+  for (i = 1; i < numChunks; i++)
+  {
+    JitChunk current = chunks[i];
+    size_t j = i;
+    for (; j > 0 && chunks[j - 1].rank > current.rank; j--)
+      chunks[j] = chunks[j - 1];
+    chunks[j] = current;
+  }
+
+  // mov eax, first * 0x01010101 ; movd xmm0, eax ; pshufd xmm0, xmm0, 0
+  emitByte (e, 0xB8);
+  emitValue(e, (unsigned char)needle[first]  * 0x01010101ULL, 4);
+  emitBytes(e, (const unsigned char*)"\x66\x0F\x6E\xC0\x66\x0F\x70\xC0\x00", 9);
+  // mov eax, second * 0x01010101 ; movd xmm1, eax ; pshufd xmm1, xmm1, 0
+  emitByte (e, 0xB8);
+  emitValue(e, (unsigned char)needle[second] * 0x01010101ULL, 4);
+  emitBytes(e, (const unsigned char*)"\x66\x0F\x6E\xC8\x66\x0F\x70\xC9\x00", 9);
+
+  // test rsi, rsi ; jz notFound
+  emitBytes(e, (const unsigned char*)"\x48\x85\xF6", 3);
+  size_t jumpNotFound = emitForwardJump(e, Jz, sizeof(Jz));
+
+  // loop: movdqu xmm2, [rdi + first] ; movdqu xmm3, [rdi + second]
+  size_t loop = e->size;
+  emitBytes(e, (const unsigned char*)"\xF3\x0F\x6F\x97", 4);
+  emitValue(e, first,  4);
+  emitBytes(e, (const unsigned char*)"\xF3\x0F\x6F\x9F", 4);
+  emitValue(e, second, 4);
+  // pcmpeqb xmm2, xmm0 ; pcmpeqb xmm3, xmm1 ; pand xmm2, xmm3 ; pmovmskb eax, xmm2 ; test eax, eax
+  emitBytes(e, (const unsigned char*)"\x66\x0F\x74\xD0\x66\x0F\x74\xD9\x66\x0F\xDB\xD3\x66\x0F\xD7\xC2\x85\xC0", 18);
+  // jnz candidates
+  size_t jumpCandidates = emitForwardJump(e, Jnz, sizeof(Jnz));
+
+  // next: add rdi, 16 ; dec rsi ; jnz loop
+  size_t next = e->size;
+  emitBytes(e, (const unsigned char*)"\x48\x83\xC7\x10\x48\xFF\xCE", 7);
+  emitJump (e, Jnz, sizeof(Jnz), loop);
+
+  // notFound: xor eax, eax ; ret
+  patchJump(e, jumpNotFound);
+  emitBytes(e, (const unsigned char*)"\x31\xC0\xC3", 3);
+
+  // candidates: bsf ecx, eax ; lea rdx, [rdi + rcx]
+  patchJump(e, jumpCandidates);
+  size_t candidates = e->size;
+  emitBytes(e, (const unsigned char*)"\x0F\xBC\xC8\x48\x8D\x14\x0F", 7);
+
+  // verify each chunk, jump to mismatch if it differs
+  size_t jumpMismatch[256 / 8 + 1];
+  size_t c;
+  for (c = 0; c < numChunks; c++)
+  {
+    uint64_t value = 0;
+    memcpy(&value, needle + chunks[c].offset, chunks[c].size);
+    switch (chunks[c].size)
+    {
+    case 8:
+      // mov r8, value ; cmp [rdx + offset], r8
+      emitBytes(e, (const unsigned char*)"\x49\xB8", 2);
+      emitValue(e, value, 8);
+      emitBytes(e, (const unsigned char*)"\x4C\x39\x82", 3);
+      emitValue(e, chunks[c].offset, 4);
+      break;
+    case 4:
+      // cmp dword [rdx + offset], value
+      emitBytes(e, (const unsigned char*)"\x81\xBA", 2);
+      emitValue(e, chunks[c].offset, 4);
+      emitValue(e, value, 4);
+      break;
+    default:
+      // cmp word [rdx + offset], value
+      emitBytes(e, (const unsigned char*)"\x66\x81\xBA", 3);
+      emitValue(e, chunks[c].offset, 4);
+      emitValue(e, value, 2);
+      break;
+    }
+    jumpMismatch[c] = emitForwardJump(e, Jnz, sizeof(Jnz));
+  }
+
+  // match: mov rax, rdx ; ret
+  emitBytes(e, (const unsigned char*)"\x48\x89\xD0\xC3", 4);
+
+  // mismatch: lea ecx, [rax - 1] ; and eax, ecx ; jnz candidates ; jmp next
+  for (c = 0; c < numChunks; c++)
+    patchJump(e, jumpMismatch[c]);
+  emitBytes(e, (const unsigned char*)"\x8D\x48\xFF\x21\xC8", 5);
+  emitJump (e, Jnz, sizeof(Jnz), candidates);
+  emitJump (e, Jmp, sizeof(Jmp), next);
+
+  return e->size;
+}
+
+#endif
+
+
+/// generate code for a needle, returns NULL if out of memory (falls back to searchNative if code generation isn't possible)
+JitSearch* compileJitSearch(const char* needle, size_t needleLength)
+{
+  // detect invalid input
+  if (!needle)
+    return NULL;
+
+  JitSearch* jit = (JitSearch*)calloc(1, sizeof(JitSearch));
+  if (!jit)
+    return NULL;
+
+  jit->needleLength = needleLength;
+  jit->needle       = (char*)malloc(needleLength + 1);
+  if (!jit->needle)
+  {
+    free(jit);
+    return NULL;
+  }
+  memcpy(jit->needle, needle, needleLength);
+
+#ifdef SEARCH_JIT
+  // a single byte is best handled by memchr()
+  if (needleLength < 2 || needleLength > JitMaxNeedle)
+    return jit;
+
+  // one page is more than enough: about 60 bytes of fixed code plus at most 23 bytes per chunk
+  const size_t PageSize = 4096;
+  void* memory = mmap(NULL, PageSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (memory == MAP_FAILED)
+    return jit;
+
+  // never writable and executable at the same time
+  if (generateCode((unsigned char*)memory, needle, needleLength) == 0 ||
+      mprotect(memory, PageSize, PROT_READ | PROT_EXEC) != 0)
+  {
+    munmap(memory, PageSize);
+    return jit;
+  }
+
+  jit->code     = memory;
+  jit->codeSize = PageSize;
+  // ISO C doesn't allow casting a data pointer to a function pointer
+  memcpy(&jit->function, &memory, sizeof(jit->function));
+#endif
+
+  return jit;
+}
+
+
+/// release executable memory
+void freeJitSearch(JitSearch* jit)
+{
+  if (!jit)
+    return;
+
+#ifdef SEARCH_JIT
+  if (jit->code)
+    munmap(jit->code, jit->codeSize);
+#endif
+  free(jit->needle);
+  free(jit);
+}
+
+
+/// same result as searchNative(haystack, haystackLength, needle, needleLength)
+const char* searchJit(const JitSearch* jit, const char* haystack, size_t haystackLength)
+{
+  // detect invalid input
+  if (!jit || !haystack || haystackLength < jit->needleLength)
+    return NULL;
+
+  size_t scanned = 0;
+  if (jit->function)
+  {
+    // the generated code reads at most needleLength - 1 bytes beyond a block's last position
+    size_t numBlocks = (haystackLength - jit->needleLength + 1) / JitBlockSize;
+    const char* result = jit->function(haystack, numBlocks);
+    if (result)
+      return result;
+    scanned = numBlocks * JitBlockSize;
+  }
+
+  // remaining bytes
+  return searchNative(haystack + scanned, haystackLength - scanned, jit->needle, jit->needleLength);
+}
+
+
+/// non-zero if machine code was generated
+int hasJitCode(const JitSearch* jit)
+{
+  return jit && jit->function;
+}
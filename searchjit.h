@@ -0,0 +1,27 @@
+// //////////////////////////////////////////////////////////
+// searchjit.h
+// Copyright (c) 2014,2019 Stephan Brumme. All rights reserved.
+// see http://create.stephan-brumme.com/disclaimer.html
+//
+
+#pragma once
+
+#include <stddef.h> // size_t
+
+// machine code generated for a single needle (x86-64 with System V calling convention, i.e. Linux/BSD/MacOS):
+// the needle's two rarest bytes are compared to 16 positions at once (SSE2),
+// candidates are verified by immediate compares ordered by rarity (rarest bytes first)
+// everything else, such as the last few bytes of a haystack or other CPUs, is handled by searchNative
+// compile with -DSEARCH_NO_JIT to disable code generation
+
+/// needle-specific search code
+typedef struct JitSearch JitSearch;
+
+/// generate code for a needle, returns NULL if out of memory (falls back to searchNative if code generation isn't possible)
+JitSearch*  compileJitSearch(const char* needle, size_t needleLength);
+/// release executable memory
+void        freeJitSearch   (JitSearch* jit);
+/// same result as searchNative(haystack, haystackLength, needle, needleLength)
+const char* searchJit       (const JitSearch* jit, const char* haystack, size_t haystackLength);
+/// non-zero if machine code was generated
+int         hasJitCode      (const JitSearch* jit);
@@ -0,0 +1,698 @@
+// //////////////////////////////////////////////////////////
+// suffixarray.c
+// Copyright (c) 2014,2019 Stephan Brumme. All rights reserved.
+// see http://create.stephan-brumme.com/disclaimer.html
+//
+
+// compiles with: gcc -Wall -std=c99 -pthread (requires fmindex.c, POSIX only: mmap, pread, pthreads)
+
+// files larger than 2 GB on 32 bit systems, pread() and mmap() aren't part of C99
+#ifndef _FILE_OFFSET_BITS
+#define _FILE_OFFSET_BITS 64
+#endif
+#ifndef _DEFAULT_SOURCE
+#define _DEFAULT_SOURCE
+#endif
+
+#include "suffixarray.h"
+#include "fmindex.h"
+
+#include <string.h>   // memcmp / memset
+#include <stdlib.h>   // malloc / free / qsort
+#include <stdio.h>    // fopen / fwrite
+#include <fcntl.h>    // open
+#include <unistd.h>   // pread / close / sysconf
+#include <sys/mman.h> // mmap
+#include <sys/stat.h> // fstat
+#include <pthread.h>
+
+
+// //////////////////////////////////////////////////////////
+// SA-IS by Ge Nong, Sen Zhang and Wai Hong Chan:
+// "Two Efficient Algorithms for Linear Time Suffix Array Construction" (2011)
+// the text has no sentinel, a virtual one smaller than all bytes follows the last position
+
+/// unused slot of the suffix array
+static const uint32_t EmptySlot = 0xFFFFFFFF;
+
+
+/// text is either made of bytes (top level) or of 32 bit names (recursion)
+static uint32_t symbol(const void* text, int wide, uint32_t pos)
+{
+  return wide ? ((const uint32_t*)text)[pos] : ((const unsigned char*)text)[pos];
+}
+
+/// beginning (or end) of each symbol's bucket
+static void getBuckets(const void* text, int wide, uint32_t length,
+                       uint32_t* buckets, uint32_t alphabetSize, int ends)
+{
+  memset(buckets, 0, alphabetSize * sizeof(uint32_t));
+  uint32_t i;
+  for (i = 0; i < length; i++)
+    buckets[symbol(text, wide, i)]++;
+
+  uint32_t sum = 0;
+  for (i = 0; i < alphabetSize; i++)
+  {
+    sum += buckets[i];
+    buckets[i] = ends ? sum : sum - buckets[i];
+  }
+}
+
+/// leftmost S-type position of a run of S-types (types[i] is non-zero for S-type)
+static int isLMS(const unsigned char* types, uint32_t pos)
+{
+  return pos > 0 && types[pos] && !types[pos - 1];
+}
+
+/// sort L-type suffixes (left to right) and S-type suffixes (right to left) based on the LMS suffixes in suffixArray
+static void induce(const void* text, int wide, uint32_t* suffixArray, uint32_t length,
+                   uint32_t* buckets, uint32_t alphabetSize, const unsigned char* types)
+{
+  uint32_t i;
+
+  // the last suffix is L-type and precedes the virtual sentinel
+  getBuckets(text, wide, length, buckets, alphabetSize, 0);
+  suffixArray[buckets[symbol(text, wide, length - 1)]++] = length - 1;
+  for (i = 0; i < length; i++)
+  {
+    uint32_t pos = suffixArray[i];
+    if (pos != EmptySlot && pos > 0 && !types[pos - 1])
+      suffixArray[buckets[symbol(text, wide, pos - 1)]++] = pos - 1;
+  }
+
+  getBuckets(text, wide, length, buckets, alphabetSize, 1);
+  for (i = length; i-- > 0; )
+  {
+    uint32_t pos = suffixArray[i];
+    if (pos != EmptySlot && pos > 0 && types[pos - 1])
+      suffixArray[--buckets[symbol(text, wide, pos - 1)]] = pos - 1;
+  }
+}
+
+/// recursive part of SA-IS, returns 0 if out of memory
+static int sais(const void* text, int wide, uint32_t* suffixArray, uint32_t length, uint32_t alphabetSize)
+{
+  if (length == 0)
+    return 1;
+  if (length == 1)
+  {
+    suffixArray[0] = 0;
+    return 1;
+  }
+
+  unsigned char* types   = (unsigned char*)malloc(length);
+  uint32_t*      buckets = (uint32_t*)     malloc(alphabetSize * sizeof(uint32_t));
+  if (!types || !buckets)
+  {
+    free(types);
+    free(buckets);
+    return 0;
+  }
+
+  // classify suffixes: S-type if smaller than its successor (the last one is larger than the virtual sentinel)
+  uint32_t i;
+  types[length - 1] = 0;
+  for (i = length - 1; i-- > 0; )
+  {
+    uint32_t current = symbol(text, wide, i);
+    uint32_t next    = symbol(text, wide, i + 1);
+    types[i] = current < next || (current == next && types[i + 1]);
+  }
+
+  // stage 1: sort LMS substrings by placing LMS positions at the end of their buckets and inducing
+  getBuckets(text, wide, length, buckets, alphabetSize, 1);
+  for (i = 0; i < length; i++)
+    suffixArray[i] = EmptySlot;
+  for (i = 1; i < length; i++)
+    if (isLMS(types, i))
+      suffixArray[--buckets[symbol(text, wide, i)]] = i;
+  induce(text, wide, suffixArray, length, buckets, alphabetSize, types);
+
+  // move sorted LMS positions to the front
+  uint32_t numLMS = 0;
+  for (i = 0; i < length; i++)
+    if (isLMS(types, suffixArray[i]))
+      suffixArray[numLMS++] = suffixArray[i];
+
+  // name LMS substrings, equal substrings get the same name (stored in the second half, two LMS positions are never adjacent)
+  for (i = numLMS; i < length; i++)
+    suffixArray[i] = EmptySlot;
+  uint32_t numNames = 0;
+  uint32_t previous = EmptySlot;
+  for (i = 0; i < numLMS; i++)
+  {
+    uint32_t pos = suffixArray[i];
+    int different = previous == EmptySlot;
+    uint32_t d;
+    for (d = 0; !different; d++)
+    {
+      // only the last LMS substring reaches the virtual sentinel
+      if (pos + d == length || previous + d == length ||
+          symbol(text, wide, pos + d) != symbol(text, wide, previous + d) || types[pos + d] != types[previous + d])
+        different = 1;
+      else if (d > 0 && isLMS(types, pos + d))
+        break;
+    }
+    if (different)
+    {
+      numNames++;
+      previous = pos;
+    }
+    suffixArray[numLMS + pos / 2] = numNames - 1;
+  }
+
+  // reduced text: names in text order, at the end of suffixArray
+  uint32_t* reduced = suffixArray + length - numLMS;
+  uint32_t j = length;
+  for (i = length; i-- > numLMS; )
+    if (suffixArray[i] != EmptySlot)
+      suffixArray[--j] = suffixArray[i];
+
+  // stage 2: sort the reduced text (recursion only if names aren't unique)
+  if (numNames < numLMS)
+  {
+    if (!sais(reduced, 1, suffixArray, numLMS, numNames))
+    {
+      free(types);
+      free(buckets);
+      return 0;
+    }
+  }
+  else
+    for (i = 0; i < numLMS; i++)
+      suffixArray[reduced[i]] = i;
+
+  // stage 3: map back to LMS positions, put them at the end of their buckets and induce all suffixes
+  j = 0;
+  for (i = 1; i < length; i++)
+    if (isLMS(types, i))
+      reduced[j++] = i;
+  for (i = 0; i < numLMS; i++)
+    suffixArray[i] = reduced[suffixArray[i]];
+  for (i = numLMS; i < length; i++)
+    suffixArray[i] = EmptySlot;
+
+  getBuckets(text, wide, length, buckets, alphabetSize, 1);
+  for (i = numLMS; i-- > 0; )
+  {
+    uint32_t pos = suffixArray[i];
+    suffixArray[i] = EmptySlot;
+    suffixArray[--buckets[symbol(text, wide, pos)]] = pos;
+  }
+  induce(text, wide, suffixArray, length, buckets, alphabetSize, types);
+
+  free(types);
+  free(buckets);
+  return 1;
+}
+
+
+/// suffix array of text[0..length) built by SA-IS, length must be less than 2^32 - 1, returns 0 if out of memory
+int createSuffixArray(const unsigned char* text, uint32_t* suffixArray, uint32_t length)
+{
+  // detect invalid input
+  if (!text || !suffixArray || length == EmptySlot)
+    return 0;
+
+  return sais(text, 0, suffixArray, length, 256);
+}
+
+
+// //////////////////////////////////////////////////////////
+// index files
+
+/// "MYINDEX1" (suffix arrays) or "MYFMIDX1" (FM-indices) plus four or five 64 bit values
+static const size_t MagicSize = 8;
+
+/// layout of an index file
+typedef struct
+{
+  uint64_t dataLength;
+  uint64_t segmentSize;
+  uint64_t maxNeedle;
+  uint64_t numSegments;
+  /// only FM-index: every sampleRate-th text position is stored, zero for suffix arrays
+  uint64_t sampleRate;
+} IndexHeader;
+
+/// size of the header
+static size_t headerSize(const IndexHeader* header)
+{
+  return MagicSize + (header->sampleRate == 0 ? 4 : 5) * sizeof(uint64_t);
+}
+
+/// bytes covered by a segment (including the overlap)
+static size_t segmentLength(const IndexHeader* header, uint64_t segment)
+{
+  uint64_t start  = segment * header->segmentSize;
+  uint64_t length = header->segmentSize + header->maxNeedle - 1;
+  if (length > header->dataLength - start)
+    length = header->dataLength - start;
+  return (size_t)length;
+}
+
+/// bytes of a segment's suffix array or FM-index
+static size_t segmentBytes(const IndexHeader* header, uint64_t segment)
+{
+  uint32_t length = (uint32_t)segmentLength(header, segment);
+  if (header->sampleRate == 0)
+    return length * sizeof(uint32_t);
+  return fmIndexSize(length, (uint32_t)header->sampleRate);
+}
+
+
+/// work of a single thread
+typedef struct
+{
+  unsigned char* text;
+  uint32_t*      suffixArray;
+  uint32_t       length;
+  /// zero for suffix arrays
+  uint32_t       sampleRate;
+  /// FM-index (uint64_t for proper alignment)
+  uint64_t*      fmIndex;
+  int            success;
+} IndexJob;
+
+static void* runJob(void* job)
+{
+  IndexJob* current = (IndexJob*)job;
+  current->success  = createSuffixArray(current->text, current->suffixArray, current->length);
+  if (!current->success || current->sampleRate == 0)
+    return NULL;
+
+  // FM-index: the suffix array is just an intermediate step
+  size_t numBytes  = fmIndexSize(current->length, current->sampleRate);
+  current->fmIndex = (uint64_t*)malloc(numBytes);
+  current->success = current->fmIndex &&
+                     createFMIndex(current->fmIndex, current->text, current->suffixArray, current->length, current->sampleRate);
+  free(current->suffixArray);
+  current->suffixArray = NULL;
+  return NULL;
+}
+
+/// read exactly length bytes
+static int readAt(int file, unsigned char* buffer, size_t length, uint64_t offset)
+{
+  while (length > 0)
+  {
+    ssize_t numRead = pread(file, buffer, length, (off_t)offset);
+    if (numRead <= 0)
+      return 0;
+    buffer += numRead;
+    length -= numRead;
+    offset += numRead;
+  }
+  return 1;
+}
+
+
+/// index a file, up to numThreads segments are processed in parallel (0 = number of CPU cores), returns 0 on failure
+int buildIndex(const char* dataFilename, const char* indexFilename,
+               size_t segmentSize, size_t maxNeedle, unsigned int numThreads, unsigned int sampleRate)
+{
+  // detect invalid input (32 bit suffix arrays)
+  if (!dataFilename || !indexFilename || segmentSize == 0 || maxNeedle == 0 ||
+      (uint64_t)segmentSize + maxNeedle >= EmptySlot)
+    return 0;
+
+  if (numThreads == 0)
+  {
+    long numCores = sysconf(_SC_NPROCESSORS_ONLN);
+    numThreads = numCores > 0 ? (unsigned int)numCores : 1;
+  }
+
+  int data = open(dataFilename, O_RDONLY);
+  if (data < 0)
+    return 0;
+  struct stat info;
+  if (fstat(data, &info) != 0)
+  {
+    close(data);
+    return 0;
+  }
+
+  IndexHeader header;
+  header.dataLength  = (uint64_t)info.st_size;
+  header.segmentSize = segmentSize;
+  header.maxNeedle   = maxNeedle;
+  header.numSegments = (header.dataLength + segmentSize - 1) / segmentSize;
+  header.sampleRate  = sampleRate;
+
+  FILE* output = fopen(indexFilename, "wb");
+  if (!output)
+  {
+    close(data);
+    return 0;
+  }
+  int success = fwrite(sampleRate == 0 ? "MYINDEX1" : "MYFMIDX1", MagicSize, 1, output) == 1 &&
+                fwrite(&header, headerSize(&header) - MagicSize, 1, output) == 1;
+
+  // streaming: only numThreads segments are in memory at the same time
+  IndexJob*  jobs    = (IndexJob*) calloc(numThreads, sizeof(IndexJob));
+  pthread_t* threads = (pthread_t*)calloc(numThreads, sizeof(pthread_t));
+  int*       started = (int*)      calloc(numThreads, sizeof(int));
+  success = success && jobs && threads && started;
+
+  uint64_t segment;
+  for (segment = 0; success && segment < header.numSegments; segment += numThreads)
+  {
+    // read a batch of segments and build their suffix arrays in parallel
+    unsigned int batch;
+    for (batch = 0; batch < numThreads && segment + batch < header.numSegments; batch++)
+    {
+      IndexJob* job    = &jobs[batch];
+      job->length      = (uint32_t)segmentLength(&header, segment + batch);
+      job->sampleRate  = sampleRate;
+      job->text        = (unsigned char*)malloc(job->length);
+      job->suffixArray = (uint32_t*)     malloc(job->length * sizeof(uint32_t));
+      job->success     = 0;
+      if (!job->text || !job->suffixArray ||
+          !readAt(data, job->text, job->length, (segment + batch) * header.segmentSize))
+        break;
+
+      // if no thread can be created then do it right now
+      started[batch] = pthread_create(&threads[batch], NULL, runJob, job) == 0;
+      if (!started[batch])
+        runJob(job);
+    }
+
+    // write in the correct order
+    unsigned int done;
+    for (done = 0; done < numThreads && segment + done < header.numSegments; done++)
+    {
+      IndexJob* job = &jobs[done];
+      if (done < batch && started[done])
+        pthread_join(threads[done], NULL);
+
+      size_t numBytes = segmentBytes(&header, segment + done);
+      const void* result = sampleRate == 0 ? (const void*)job->suffixArray : (const void*)job->fmIndex;
+      success = success && done < batch && job->success &&
+                fwrite(result, 1, numBytes, output) == numBytes;
+
+      free(job->text);
+      free(job->suffixArray);
+      free(job->fmIndex);
+      job->text        = NULL;
+      job->suffixArray = NULL;
+      job->fmIndex     = NULL;
+      started[done]    = 0;
+    }
+  }
+
+  free(jobs);
+  free(threads);
+  free(started);
+  close(data);
+  if (fclose(output) != 0)
+    success = 0;
+  // don't leave a broken index behind
+  if (!success)
+    remove(indexFilename);
+  return success;
+}
+
+
+// //////////////////////////////////////////////////////////
+// queries
+
+/// memory-mapped index plus its data file
+struct SuffixIndex
+{
+  IndexHeader           header;
+  /// whole index file
+  const unsigned char*  index;
+  size_t                indexLength;
+  /// whole data file
+  const char*           data;
+  /// start of each segment's suffix array or FM-index
+  const unsigned char** segments;
+};
+
+
+/// map a file read-only, returns 0 on failure (an empty file is fine)
+int mapFile(const char* filename, const void** memory, size_t* length)
+{
+  int file = open(filename, O_RDONLY);
+  if (file < 0)
+    return 0;
+
+  struct stat info;
+  int success = fstat(file, &info) == 0;
+  *memory = NULL;
+  *length = success ? (size_t)info.st_size : 0;
+  if (success && *length > 0)
+  {
+    void* mapped = mmap(NULL, *length, PROT_READ, MAP_SHARED, file, 0);
+    success = mapped != MAP_FAILED;
+    if (success)
+      *memory = mapped;
+  }
+
+  close(file);
+  return success;
+}
+
+
+/// map index and data file, returns NULL if they don't belong together (or on failure)
+SuffixIndex* openIndex(const char* indexFilename, const char* dataFilename)
+{
+  // detect invalid input
+  if (!indexFilename || !dataFilename)
+    return NULL;
+
+  SuffixIndex* index = (SuffixIndex*)calloc(1, sizeof(SuffixIndex));
+  if (!index)
+    return NULL;
+
+  const void* mapped = NULL;
+  size_t dataLength;
+  int success = mapFile(indexFilename, &mapped, &index->indexLength);
+  index->index = (const unsigned char*)mapped;
+  mapped  = NULL;
+  success = success && mapFile(dataFilename, &mapped, &dataLength);
+  index->data  = (const char*)mapped;
+
+  // check header, suffix arrays don't store a sample rate
+  success = success && index->indexLength >= MagicSize + 4 * sizeof(uint64_t);
+  if (success)
+  {
+    int isFMIndex = memcmp(index->index, "MYFMIDX1", MagicSize) == 0;
+    success = (isFMIndex && index->indexLength >= MagicSize + 5 * sizeof(uint64_t)) ||
+              memcmp(index->index, "MYINDEX1", MagicSize) == 0;
+    index->header.sampleRate = 0;
+    if (success)
+      memcpy(&index->header, index->index + MagicSize, (isFMIndex ? 5 : 4) * sizeof(uint64_t));
+
+    success = success && index->header.dataLength == dataLength &&
+              index->header.segmentSize > 0 && index->header.maxNeedle > 0 &&
+              (!isFMIndex || index->header.sampleRate > 0) &&
+              index->header.numSegments == (dataLength + index->header.segmentSize - 1) / index->header.segmentSize;
+  }
+
+  // locate all segments and make sure the index file is complete
+  if (success)
+  {
+    index->segments = (const unsigned char**)malloc((index->header.numSegments + 1) * sizeof(unsigned char*));
+    success = index->segments != NULL;
+
+    size_t offset = headerSize(&index->header);
+    uint64_t segment;
+    for (segment = 0; success && segment < index->header.numSegments; segment++)
+    {
+      index->segments[segment] = index->index + offset;
+      offset += segmentBytes(&index->header, segment);
+    }
+    success = success && offset == index->indexLength;
+  }
+
+  if (!success)
+  {
+    closeIndex(index);
+    return NULL;
+  }
+  return index;
+}
+
+
+/// unmap both files
+void closeIndex(SuffixIndex* index)
+{
+  if (!index)
+    return;
+
+  if (index->index)
+    munmap((void*)index->index, index->indexLength);
+  if (index->data)
+    munmap((void*)index->data, (size_t)index->header.dataLength);
+  free(index->segments);
+  free(index);
+}
+
+
+/// the memory-mapped data file
+const char* indexData(const SuffixIndex* index, size_t* dataLength)
+{
+  if (!index)
+    return NULL;
+
+  if (dataLength)
+    *dataLength = (size_t)index->header.dataLength;
+  return index->data;
+}
+
+
+/// longest needle the index can find
+size_t indexMaxNeedle(const SuffixIndex* index)
+{
+  return index ? (size_t)index->header.maxNeedle : 0;
+}
+
+
+/// compare a suffix to the needle, a suffix shorter than needle is smaller if both are equal as far as possible
+static int compareSuffix(const char* text, size_t textLength, uint32_t suffix,
+                         const char* needle, size_t needleLength)
+{
+  size_t available = textLength - suffix;
+  int result = memcmp(text + suffix, needle, available < needleLength ? available : needleLength);
+  if (result != 0)
+    return result;
+  return available < needleLength ? -1 : 0;
+}
+
+/// rows [first, last) of a segment's suffix array or FM-index start with needle
+static void segmentRange(const SuffixIndex* index, uint64_t segment, const char* needle, size_t needleLength,
+                         size_t* first, size_t* last)
+{
+  size_t textLength = segmentLength(&index->header, segment);
+
+  // FM-index: backward search
+  if (index->header.sampleRate > 0)
+  {
+    uint32_t begin, end;
+    fmIndexCount(index->segments[segment], (uint32_t)textLength, needle, needleLength, &begin, &end);
+    *first = begin;
+    *last  = end;
+    return;
+  }
+
+  const uint32_t* suffixArray = (const uint32_t*)index->segments[segment];
+  const char*     text        = index->data + segment * index->header.segmentSize;
+
+  // binary search: first suffix not smaller than needle
+  size_t low = 0, high = textLength;
+  while (low < high)
+  {
+    size_t middle = low + (high - low) / 2;
+    if (compareSuffix(text, textLength, suffixArray[middle], needle, needleLength) < 0)
+      low = middle + 1;
+    else
+      high = middle;
+  }
+  *first = low;
+
+  // first suffix larger than needle
+  high = textLength;
+  while (low < high)
+  {
+    size_t middle = low + (high - low) / 2;
+    if (compareSuffix(text, textLength, suffixArray[middle], needle, needleLength) <= 0)
+      low = middle + 1;
+    else
+      high = middle;
+  }
+  *last = low;
+}
+
+/// position of a row relative to the segment's beginning
+static size_t segmentPosition(const SuffixIndex* index, uint64_t segment, size_t row)
+{
+  if (index->header.sampleRate > 0)
+    return fmIndexLocate(index->segments[segment], (uint32_t)segmentLength(&index->header, segment), (uint32_t)row);
+  return ((const uint32_t*)index->segments[segment])[row];
+}
+
+/// for qsort()
+static int comparePosition(const void* a, const void* b)
+{
+  size_t x = *(const size_t*)a;
+  size_t y = *(const size_t*)b;
+  return (x > y) - (x < y);
+}
+
+
+/// positions of all matches in ascending order (release with free), NULL if none or needle is longer than indexMaxNeedle
+size_t* queryIndex(const SuffixIndex* index, const char* needle, size_t needleLength, size_t* numMatches)
+{
+  if (numMatches)
+    *numMatches = 0;
+  // detect invalid input
+  if (!index || !needle || !numMatches || needleLength == 0 || needleLength > index->header.maxNeedle)
+    return NULL;
+
+  size_t* matches  = NULL;
+  size_t  capacity = 0;
+
+  uint64_t segment;
+  for (segment = 0; segment < index->header.numSegments; segment++)
+  {
+    size_t first, last;
+    segmentRange(index, segment, needle, needleLength, &first, &last);
+
+    size_t row;
+    for (row = first; row < last; row++)
+    {
+      // matches starting in the overlap belong to the next segment
+      size_t pos = segmentPosition(index, segment, row);
+      if (pos >= index->header.segmentSize)
+        continue;
+
+      if (*numMatches == capacity)
+      {
+        capacity = capacity == 0 ? 64 : 2 * capacity;
+        size_t* resized = (size_t*)realloc(matches, capacity * sizeof(size_t));
+        if (!resized)
+        {
+          free(matches);
+          *numMatches = 0;
+          return NULL;
+        }
+        matches = resized;
+      }
+      matches[(*numMatches)++] = (size_t)(segment * index->header.segmentSize) + pos;
+    }
+  }
+
+  // suffix arrays are sorted lexicographically, not by position
+  if (matches)
+    qsort(matches, *numMatches, sizeof(size_t), comparePosition);
+  return matches;
+}
+
+
+/// number of matches without locating them (FM-index: O(m) per segment)
+size_t countIndex(const SuffixIndex* index, const char* needle, size_t needleLength)
+{
+  // detect invalid input
+  if (!index || !needle || needleLength == 0 || needleLength > index->header.maxNeedle)
+    return 0;
+
+  size_t result = 0;
+  uint64_t segment;
+  for (segment = 0; segment < index->header.numSegments; segment++)
+  {
+    size_t first, last;
+    segmentRange(index, segment, needle, needleLength, &first, &last);
+    result += last - first;
+
+    // matches starting in the overlap are counted by the next segment, too (the overlap is short, just compare)
+    size_t textLength = segmentLength(&index->header, segment);
+    const char* text  = index->data + segment * index->header.segmentSize;
+    size_t pos;
+    for (pos = (size_t)index->header.segmentSize; pos + needleLength <= textLength; pos++)
+      if (memcmp(text + pos, needle, needleLength) == 0)
+        result--;
+  }
+  return result;
+}
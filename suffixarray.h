@@ -0,0 +1,51 @@
+// //////////////////////////////////////////////////////////
+// suffixarray.h
+// Copyright (c) 2014,2019 Stephan Brumme. All rights reserved.
+// see http://create.stephan-brumme.com/disclaimer.html
+//
+
+#pragma once
+
+#include <stddef.h> // size_t
+#include <stdint.h> // uint32_t
+
+// persistent index for many queries against the same (large, immutable) file:
+// the file is split into segments, each one overlaps the next by maxNeedle - 1 bytes
+// and has its own suffix array (32 bit entries, built by SA-IS in linear time)
+// a query does a binary search in each segment's suffix array: O(m log n)
+//
+// segments may store an FM-index instead (see fmindex.h): about a third of the size, but locating each match is slower
+//
+// index file layout (native byte order):
+// "MYINDEX1", uint64_t dataLength, uint64_t segmentSize, uint64_t maxNeedle, uint64_t numSegments,
+// followed by one uint32_t suffix array per segment (segment k starts at k * segmentSize and is
+// min(segmentSize + maxNeedle - 1, dataLength - k * segmentSize) bytes long)
+// or "MYFMIDX1", the same four values plus uint64_t sampleRate, followed by one FM-index per segment
+
+/// suffix array of text[0..length) built by SA-IS, length must be less than 2^32 - 1, returns 0 if out of memory
+int          createSuffixArray(const unsigned char* text, uint32_t* suffixArray, uint32_t length);
+
+/// index a file, up to numThreads segments are processed in parallel (0 = number of CPU cores), returns 0 on failure
+/** sampleRate = 0 stores suffix arrays, else FM-indices where every sampleRate-th text position is kept
+    memory consumption is about 6 * (segmentSize + maxNeedle) bytes per thread (FM-index: 8 bytes) **/
+int          buildIndex       (const char* dataFilename, const char* indexFilename,
+                               size_t segmentSize, size_t maxNeedle, unsigned int numThreads, unsigned int sampleRate);
+
+/// memory-mapped index plus its data file
+typedef struct SuffixIndex SuffixIndex;
+
+/// map index and data file, returns NULL if they don't belong together (or on failure)
+SuffixIndex* openIndex        (const char* indexFilename, const char* dataFilename);
+/// unmap both files
+void         closeIndex       (SuffixIndex* index);
+/// the memory-mapped data file
+const char*  indexData        (const SuffixIndex* index, size_t* dataLength);
+/// longest needle the index can find
+size_t       indexMaxNeedle   (const SuffixIndex* index);
+/// positions of all matches in ascending order (release with free), NULL if none or needle is longer than indexMaxNeedle
+size_t*      queryIndex       (const SuffixIndex* index, const char* needle, size_t needleLength, size_t* numMatches);
+/// number of matches without locating them (FM-index: O(m) per segment)
+size_t       countIndex       (const SuffixIndex* index, const char* needle, size_t needleLength);
+
+/// map a file read-only (release with munmap), returns 0 on failure (an empty file is fine), shared with blockfilter.c
+int          mapFile          (const char* filename, const void** memory, size_t* length);
@@ -0,0 +1,51 @@
+#!/bin/sh
+# //////////////////////////////////////////////////////////
+# test.sh
+# Copyright (c) 2014,2019 Stephan Brumme. All rights reserved.
+# see http://create.stephan-brumme.com/disclaimer.html
+#
+
+# regression tests for mygrep, run after building it: ./test.sh [path to mygrep]
+# each test must finish within a few seconds (timeout), exits with the number of failed tests
+
+MYGREP=${1:-./mygrep}
+TEMP=$(mktemp -d)
+trap 'rm -rf "$TEMP"' EXIT
+FAILED=0
+
+# expect "description" "expected output" mygrep-arguments ...
+expect()
+{
+  DESCRIPTION=$1
+  EXPECTED=$2
+  shift 2
+  ACTUAL=$(timeout 5 "$MYGREP" "$@")
+  if [ $? -eq 124 ]; then
+    echo "FAILED: $DESCRIPTION (timeout)"
+    FAILED=$((FAILED + 1))
+  elif [ "$ACTUAL" != "$EXPECTED" ]; then
+    echo "FAILED: $DESCRIPTION"
+    echo "  expected: $EXPECTED"
+    echo "  actual:   $ACTUAL"
+    FAILED=$((FAILED + 1))
+  fi
+}
+
+# regular expressions matching an empty line, the file starts with an empty line
+printf '\nabc\n' > "$TEMP/empty-first.txt"
+expect "-E ^\$ counts the leading empty line once" "1" '^$' "$TEMP/empty-first.txt" -E -c
+expect "-E x? matches each line once"            "$(printf '1:\n2:abc')" 'x?' "$TEMP/empty-first.txt" -E -n
+
+printf '\n\nabc\n\nx\n' > "$TEMP/empty-lines.txt"
+expect "-E ^\$ finds all empty lines"            "$(printf '1:\n2:\n4:')" '^$' "$TEMP/empty-lines.txt" -E -n
+
+# stacked quantifiers on a long line which contains the literal "xy" but doesn't match
+{ printf 'xy'; printf '%3000s' '' | tr ' ' a; echo; } > "$TEMP/long-line.txt"
+expect "-E xya*a*a*b doesn't backtrack"          "0" 'xya*a*a*b'   "$TEMP/long-line.txt" -E -c
+expect "-E xy.*.*.*.*b doesn't backtrack"        "0" 'xy.*.*.*.*b' "$TEMP/long-line.txt" -E -c
+expect "-E xy.*a\$ matches the long line"         "1" 'xy.*a$'      "$TEMP/long-line.txt" -E -c
+
+if [ $FAILED -eq 0 ]; then
+  echo "all tests passed"
+fi
+exit $FAILED
@@ -0,0 +1,865 @@
+// //////////////////////////////////////////////////////////
+// trigramindex.c
+// Copyright (c) 2014,2019 Stephan Brumme. All rights reserved.
+// see http://create.stephan-brumme.com/disclaimer.html
+//
+
+// compiles with: gcc -Wall -std=c99 (POSIX only: mmap, opendir)
+
+// files larger than 2 GB on 32 bit systems, lstat() and mmap() aren't part of C99
+#ifndef _FILE_OFFSET_BITS
+#define _FILE_OFFSET_BITS 64
+#endif
+#ifndef _DEFAULT_SOURCE
+#define _DEFAULT_SOURCE
+#endif
+
+#include "trigramindex.h"
+
+#include <string.h>   // memcmp / memcpy / memchr / strcmp
+#include <stdlib.h>   // malloc / free / qsort
+#include <stdio.h>    // fopen / fwrite / rename
+#include <fcntl.h>    // open
+#include <unistd.h>   // close
+#include <dirent.h>   // opendir / readdir
+#include <sys/mman.h> // mmap
+#include <sys/stat.h> // stat / lstat
+
+
+/// "MYTRIGR2" plus three 64 bit values
+static const size_t   MagicSize   = 8;
+/// 2^24 possible trigrams
+static const uint32_t NumTrigrams = 1 << 24;
+/// invalid file ID
+static const uint32_t NoFile      = 0xFFFFFFFF;
+/// files are read in blocks of 64k
+static const size_t   BlockSize   = 64 * 1024;
+/// flag of a file table entry: file contains zero bytes, it's listed without trigrams (so that unchanged binary files aren't read again)
+static const uint64_t FileBinary  = 1;
+
+
+/// layout of an index file
+typedef struct
+{
+  uint64_t numFiles;
+  uint64_t numTrigrams;
+  uint64_t namesLength;
+} TrigramHeader;
+
+/// one entry of the file table
+typedef struct
+{
+  int64_t  mtime;
+  uint64_t size;
+  /// relative to the first filename
+  uint64_t nameOffset;
+  /// FileBinary or zero
+  uint64_t flags;
+} FileEntry;
+
+/// one entry of the trigram table
+typedef struct
+{
+  uint32_t trigram;
+  uint32_t numFiles;
+  /// relative to the start of the index file
+  uint64_t offset;
+} TrigramEntry;
+
+struct TrigramIndex
+{
+  const unsigned char* memory;
+  size_t               length;
+  TrigramHeader        header;
+  const FileEntry*     files;
+  const char*          names;
+  const TrigramEntry*  trigrams;
+};
+
+
+/// round up to a multiple of 8
+static uint64_t align8(uint64_t size)
+{
+  return (size + 7) & ~(uint64_t)7;
+}
+
+
+// //////////////////////////////////////////////////////////
+// posting lists: differences of ascending file IDs, 7 bits per byte, highest bit set if more bytes follow
+
+/// append a variable-length integer (at most 5 bytes), returns pointer to the next byte
+static unsigned char* encodeVarint(unsigned char* output, uint32_t value)
+{
+  while (value >= 0x80)
+  {
+    *output++ = (unsigned char)(value | 0x80);
+    value >>= 7;
+  }
+  *output++ = (unsigned char)value;
+  return output;
+}
+
+/// decode a variable-length integer, returns pointer to the next byte
+static const unsigned char* decodeVarint(const unsigned char* input, uint32_t* value)
+{
+  uint32_t result = 0;
+  int      shift  = 0;
+  while (*input & 0x80)
+  {
+    result |= (uint32_t)(*input++ & 0x7F) << shift;
+    shift  += 7;
+  }
+  *value = result | ((uint32_t)*input++ << shift);
+  return input;
+}
+
+/// sequential reader of a posting list
+typedef struct
+{
+  const unsigned char* current;
+  uint32_t             remaining;
+  /// most recently decoded file ID
+  uint32_t             file;
+} PostingReader;
+
+/// decode next file ID, returns 0 if the list is exhausted
+static int nextPosting(PostingReader* reader)
+{
+  if (reader->remaining == 0)
+    return 0;
+
+  uint32_t delta;
+  reader->current = decodeVarint(reader->current, &delta);
+  reader->file   += delta;
+  reader->remaining--;
+  return 1;
+}
+
+
+/// growable block of memory
+typedef struct
+{
+  unsigned char* data;
+  size_t         size;
+  size_t         capacity;
+} Buffer;
+
+/// make sure that at least extra more bytes fit, returns 0 if out of memory
+static int reserve(Buffer* buffer, size_t extra)
+{
+  if (buffer->size + extra <= buffer->capacity)
+    return 1;
+
+  size_t capacity = buffer->capacity > 0 ? buffer->capacity * 2 : 64;
+  while (capacity < buffer->size + extra)
+    capacity *= 2;
+  unsigned char* data = (unsigned char*)realloc(buffer->data, capacity);
+  if (!data)
+    return 0;
+
+  buffer->data     = data;
+  buffer->capacity = capacity;
+  return 1;
+}
+
+
+/// posting list of files read during an update
+typedef struct
+{
+  Buffer   encoded;
+  uint32_t numFiles;
+  /// most recently added file ID
+  uint32_t last;
+} Postings;
+
+/// add a file to a trigram's posting list (file IDs must be ascending), returns 0 if out of memory
+/** chunks has 65536 entries of 256 trigrams each, they are allocated when needed **/
+static int addPosting(Postings** chunks, uint32_t trigram, uint32_t file)
+{
+  Postings* chunk = chunks[trigram >> 8];
+  if (!chunk)
+  {
+    chunk = (Postings*)calloc(256, sizeof(Postings));
+    if (!chunk)
+      return 0;
+    chunks[trigram >> 8] = chunk;
+  }
+
+  Postings* list = &chunk[trigram & 0xFF];
+  if (!reserve(&list->encoded, 5))
+    return 0;
+
+  uint32_t delta = list->numFiles > 0 ? file - list->last : file;
+  list->encoded.size = encodeVarint(list->encoded.data + list->encoded.size, delta) - list->encoded.data;
+  list->numFiles++;
+  list->last = file;
+  return 1;
+}
+
+
+// //////////////////////////////////////////////////////////
+// collect files
+
+/// name, modification time and size of a file
+typedef struct
+{
+  char*    name;
+  int64_t  mtime;
+  uint64_t size;
+  /// FileBinary or zero
+  uint64_t flags;
+} FileInfo;
+
+/// growable array of files
+typedef struct
+{
+  FileInfo* files;
+  size_t    numFiles;
+  size_t    capacity;
+} FileList;
+
+/// append a file, takes ownership of name, returns 0 if out of memory
+static int addFile(FileList* list, char* name, const struct stat* info)
+{
+  if (list->numFiles == list->capacity)
+  {
+    size_t capacity = list->capacity > 0 ? list->capacity * 2 : 1024;
+    FileInfo* files = (FileInfo*)realloc(list->files, capacity * sizeof(FileInfo));
+    if (!files)
+    {
+      free(name);
+      return 0;
+    }
+    list->files    = files;
+    list->capacity = capacity;
+  }
+
+  FileInfo* file = &list->files[list->numFiles++];
+  file->name  = name;
+  file->mtime = (int64_t)info->st_mtime;
+  file->size  = (uint64_t)info->st_size;
+  file->flags = 0;
+  return 1;
+}
+
+/// concatenate directory and filename, returns NULL if out of memory
+static char* joinPath(const char* directory, const char* name)
+{
+  size_t directoryLength = strlen(directory);
+  size_t nameLength      = strlen(name);
+  char*  result = (char*)malloc(directoryLength + nameLength + 2);
+  if (!result)
+    return NULL;
+
+  memcpy(result, directory, directoryLength);
+  // avoid double slashes
+  if (directoryLength > 0 && directory[directoryLength - 1] != '/')
+    result[directoryLength++] = '/';
+  memcpy(result + directoryLength, name, nameLength + 1);
+  return result;
+}
+
+/// add all regular files of a directory and its subdirectories (symbolic links are ignored), returns 0 if out of memory
+static int scanDirectory(FileList* list, const char* path)
+{
+  // unreadable directories are skipped
+  DIR* directory = opendir(path);
+  if (!directory)
+    return 1;
+
+  int success = 1;
+  struct dirent* entry;
+  while (success && (entry = readdir(directory)) != NULL)
+  {
+    if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0)
+      continue;
+
+    char* name = joinPath(path, entry->d_name);
+    success = name != NULL;
+    struct stat info;
+    if (!success || lstat(name, &info) != 0)
+    {
+      free(name);
+      continue;
+    }
+
+    if (S_ISDIR(info.st_mode))
+    {
+      success = scanDirectory(list, name);
+      free(name);
+    }
+    else if (S_ISREG(info.st_mode))
+      success = addFile(list, name, &info);
+    else
+      free(name);
+  }
+
+  closedir(directory);
+  return success;
+}
+
+/// sort by filename
+static int compareFiles(const void* a, const void* b)
+{
+  return strcmp(((const FileInfo*)a)->name, ((const FileInfo*)b)->name);
+}
+
+
+/// read a file and collect its distinct trigrams, returns 1 for text files, 2 for binary files, 0 for unreadable files, -1 if out of memory
+/** seen is a bit vector of all 2^24 trigrams which is cleared again before returning **/
+static int readTrigrams(const char* filename, uint64_t* seen, Buffer* trigrams, unsigned char* block)
+{
+  trigrams->size = 0;
+  FILE* file = fopen(filename, "rb");
+  if (!file)
+    return 0;
+
+  int      result   = 1;
+  // the most recent bytes, only the lowest three form a trigram
+  uint32_t previous = 0;
+  size_t   total    = 0;
+  size_t   numRead;
+  while (result == 1 && (numRead = fread(block, 1, BlockSize, file)) > 0)
+  {
+    // binary files contain zeros
+    if (memchr(block, 0, numRead))
+    {
+      result = 2;
+      break;
+    }
+
+    size_t i;
+    for (i = 0; i < numRead; i++)
+    {
+      previous = (previous << 8) | block[i];
+      if (++total < 3)
+        continue;
+
+      uint32_t trigram = previous & 0xFFFFFF;
+      uint64_t mask    = (uint64_t)1 << (trigram % 64);
+      if (seen[trigram / 64] & mask)
+        continue;
+
+      if (!reserve(trigrams, sizeof(uint32_t)))
+      {
+        result = -1;
+        break;
+      }
+      seen[trigram / 64] |= mask;
+      memcpy(trigrams->data + trigrams->size, &trigram, sizeof(uint32_t));
+      trigrams->size += sizeof(uint32_t);
+    }
+  }
+  if (ferror(file))
+    result = 0;
+  fclose(file);
+
+  // reset bit vector
+  size_t i;
+  for (i = 0; i < trigrams->size; i += sizeof(uint32_t))
+  {
+    uint32_t trigram;
+    memcpy(&trigram, trigrams->data + i, sizeof(uint32_t));
+    seen[trigram / 64] &= ~((uint64_t)1 << (trigram % 64));
+  }
+  return result;
+}
+
+
+/// find a file of an index, returns NoFile if it isn't indexed
+static uint32_t findFile(const TrigramIndex* index, const char* name)
+{
+  // file table is sorted by name
+  size_t left = 0, right = (size_t)index->header.numFiles;
+  while (left < right)
+  {
+    size_t middle = left + (right - left) / 2;
+    const char* current = trigramIndexFilename(index, (uint32_t)middle);
+    int compare = current ? strcmp(current, name) : -1;
+    if (compare == 0)
+      return (uint32_t)middle;
+    if (compare < 0)
+      left  = middle + 1;
+    else
+      right = middle;
+  }
+  return NoFile;
+}
+
+/// binary search in the trigram table, returns NULL if no file contains the trigram
+static const TrigramEntry* findTrigram(const TrigramIndex* index, uint32_t trigram)
+{
+  size_t left = 0, right = (size_t)index->header.numTrigrams;
+  while (left < right)
+  {
+    size_t middle = left + (right - left) / 2;
+    if (index->trigrams[middle].trigram == trigram)
+      return &index->trigrams[middle];
+    if (index->trigrams[middle].trigram < trigram)
+      left  = middle + 1;
+    else
+      right = middle;
+  }
+  return NULL;
+}
+
+
+/// write files and merged posting lists (old ones are renumbered), returns 0 on failure
+static int writeIndex(FILE* output, const FileList* list, const TrigramIndex* previous, const uint32_t* renumber,
+                      Postings** chunks)
+{
+  // header, number of trigrams is patched afterwards
+  TrigramHeader header;
+  header.numFiles    = list->numFiles;
+  header.numTrigrams = 0;
+  header.namesLength = 0;
+  size_t i;
+  for (i = 0; i < list->numFiles; i++)
+    header.namesLength += strlen(list->files[i].name) + 1;
+
+  int success = fwrite("MYTRIGR2", MagicSize, 1, output) == 1 &&
+                fwrite(&header, sizeof(header), 1, output) == 1;
+
+  // file table and filenames
+  uint64_t nameOffset = 0;
+  for (i = 0; success && i < list->numFiles; i++)
+  {
+    FileEntry entry;
+    entry.mtime      = list->files[i].mtime;
+    entry.size       = list->files[i].size;
+    entry.nameOffset = nameOffset;
+    entry.flags      = list->files[i].flags;
+    nameOffset += strlen(list->files[i].name) + 1;
+    success = fwrite(&entry, sizeof(entry), 1, output) == 1;
+  }
+  for (i = 0; success && i < list->numFiles; i++)
+    success = fwrite(list->files[i].name, strlen(list->files[i].name) + 1, 1, output) == 1;
+
+  static const unsigned char Padding[8] = { 0 };
+  size_t padding = (size_t)(align8(header.namesLength) - header.namesLength);
+  if (success && padding > 0)
+    success = fwrite(Padding, padding, 1, output) == 1;
+  uint64_t offset = MagicSize + sizeof(header) + header.numFiles * sizeof(FileEntry) + align8(header.namesLength);
+
+  // merge posting lists of both sources, all files are either taken from the previous index or read again
+  Buffer table   = { NULL, 0, 0 };
+  Buffer encoded = { NULL, 0, 0 };
+  size_t nextPrevious = 0;
+  uint32_t trigram;
+  for (trigram = 0; success && trigram < NumTrigrams; trigram++)
+  {
+    PostingReader old = { NULL, 0, 0 };
+    if (previous && nextPrevious < previous->header.numTrigrams &&
+        previous->trigrams[nextPrevious].trigram == trigram)
+    {
+      old.current   = previous->memory + previous->trigrams[nextPrevious].offset;
+      old.remaining = previous->trigrams[nextPrevious].numFiles;
+      nextPrevious++;
+    }
+
+    PostingReader scanned = { NULL, 0, 0 };
+    const Postings* chunk = chunks[trigram >> 8];
+    if (chunk)
+    {
+      scanned.current   = chunk[trigram & 0xFF].encoded.data;
+      scanned.remaining = chunk[trigram & 0xFF].numFiles;
+    }
+
+    if (old.remaining == 0 && scanned.remaining == 0)
+      continue;
+
+    // next file of the previous index which still exists unchanged
+    uint32_t oldFile = NoFile;
+    while (oldFile == NoFile && nextPosting(&old))
+      oldFile = renumber[old.file];
+    uint32_t newFile = nextPosting(&scanned) ? scanned.file : NoFile;
+
+    // both lists are ascending and disjoint
+    uint32_t numFiles = 0, last = 0;
+    encoded.size = 0;
+    while (success && (oldFile != NoFile || newFile != NoFile))
+    {
+      uint32_t file;
+      if (oldFile < newFile)
+      {
+        file    = oldFile;
+        oldFile = NoFile;
+        while (oldFile == NoFile && nextPosting(&old))
+          oldFile = renumber[old.file];
+      }
+      else
+      {
+        file    = newFile;
+        newFile = nextPosting(&scanned) ? scanned.file : NoFile;
+      }
+
+      success = reserve(&encoded, 5);
+      if (success)
+        encoded.size = encodeVarint(encoded.data + encoded.size, numFiles > 0 ? file - last : file) - encoded.data;
+      last = file;
+      numFiles++;
+    }
+
+    // all files containing this trigram were removed or modified
+    if (!success || numFiles == 0)
+      continue;
+
+    TrigramEntry entry;
+    entry.trigram  = trigram;
+    entry.numFiles = numFiles;
+    entry.offset   = offset;
+    success = reserve(&table, sizeof(entry)) &&
+              fwrite(encoded.data, encoded.size, 1, output) == 1;
+    if (success)
+    {
+      memcpy(table.data + table.size, &entry, sizeof(entry));
+      table.size += sizeof(entry);
+      offset     += encoded.size;
+    }
+  }
+
+  // trigram table
+  padding = (size_t)(align8(offset) - offset);
+  if (success && padding > 0)
+    success = fwrite(Padding, padding, 1, output) == 1;
+  if (success && table.size > 0)
+    success = fwrite(table.data, table.size, 1, output) == 1;
+
+  header.numTrigrams = table.size / sizeof(TrigramEntry);
+  success = success && fseek(output, (long)MagicSize, SEEK_SET) == 0 &&
+            fwrite(&header, sizeof(header), 1, output) == 1;
+
+  free(table.data);
+  free(encoded.data);
+  return success;
+}
+
+
+/// create or update an index of all regular files in paths (directories are scanned recursively), returns 0 on failure
+int updateTrigramIndex(const char* indexFilename, const char* const* paths, size_t numPaths, size_t* numScanned)
+{
+  // detect invalid input
+  if (!indexFilename || (!paths && numPaths > 0))
+    return 0;
+  if (numScanned)
+    *numScanned = 0;
+
+  // find all files
+  FileList list = { NULL, 0, 0 };
+  int success = 1;
+  size_t i;
+  for (i = 0; success && i < numPaths; i++)
+  {
+    // paths must exist, symbolic links are followed only here
+    struct stat info;
+    success = stat(paths[i], &info) == 0;
+    if (!success)
+      break;
+
+    if (S_ISDIR(info.st_mode))
+      success = scanDirectory(&list, paths[i]);
+    else if (S_ISREG(info.st_mode))
+    {
+      char* name = joinPath("", paths[i]);
+      success = name && addFile(&list, name, &info);
+    }
+  }
+
+  // sort by name and remove duplicates
+  if (list.numFiles > 0)
+    qsort(list.files, list.numFiles, sizeof(FileInfo), compareFiles);
+  size_t numUnique = 0;
+  for (i = 0; i < list.numFiles; i++)
+    if (numUnique > 0 && strcmp(list.files[numUnique - 1].name, list.files[i].name) == 0)
+      free(list.files[i].name);
+    else
+      list.files[numUnique++] = list.files[i];
+  list.numFiles = numUnique;
+  success = success && list.numFiles < NoFile;
+
+  // previous index is optional, its file IDs are mapped to the new IDs
+  TrigramIndex* previous = success ? openTrigramIndex(indexFilename) : NULL;
+  uint32_t* renumber = NULL;
+  if (previous)
+  {
+    renumber = (uint32_t*)malloc(((size_t)previous->header.numFiles + 1) * sizeof(uint32_t));
+    success  = renumber != NULL;
+    for (i = 0; success && i < previous->header.numFiles; i++)
+      renumber[i] = NoFile;
+  }
+
+  Postings**     chunks   = (Postings**)calloc(NumTrigrams >> 8, sizeof(Postings*));
+  uint64_t*      seen     = (uint64_t*) calloc(NumTrigrams / 64, sizeof(uint64_t));
+  unsigned char* block    = (unsigned char*)malloc(BlockSize);
+  Buffer         trigrams = { NULL, 0, 0 };
+  success = success && chunks && seen && block;
+
+  // read new and modified files, binary files are listed without trigrams, unreadable files are dropped
+  uint32_t numFiles = 0;
+  for (i = 0; success && i < list.numFiles; i++)
+  {
+    FileInfo* file = &list.files[i];
+    uint32_t  old  = previous ? findFile(previous, file->name) : NoFile;
+    if (old != NoFile && previous->files[old].mtime == file->mtime && previous->files[old].size == file->size)
+    {
+      renumber[old] = numFiles;
+      file->flags   = previous->files[old].flags;
+      list.files[numFiles++] = *file;
+      continue;
+    }
+
+    if (numScanned)
+      (*numScanned)++;
+    int result = readTrigrams(file->name, seen, &trigrams, block);
+    success = result >= 0;
+
+    size_t pos;
+    for (pos = 0; success && result == 1 && pos < trigrams.size; pos += sizeof(uint32_t))
+    {
+      uint32_t trigram;
+      memcpy(&trigram, trigrams.data + pos, sizeof(uint32_t));
+      success = addPosting(chunks, trigram, numFiles);
+    }
+
+    if (result > 0)
+    {
+      file->flags = result == 2 ? FileBinary : 0;
+      list.files[numFiles++] = *file;
+    }
+    else
+      free(file->name);
+  }
+  // release names of files which weren't processed (out of memory)
+  for (; i < list.numFiles; i++)
+    free(list.files[i].name);
+  list.numFiles = numFiles;
+
+  // write to a temporary file and replace the previous index afterwards
+  char* tempFilename = (char*)malloc(strlen(indexFilename) + 5);
+  if (tempFilename)
+  {
+    strcpy(tempFilename, indexFilename);
+    strcat(tempFilename, ".tmp");
+  }
+  success = success && tempFilename;
+  if (success)
+  {
+    FILE* output = fopen(tempFilename, "wb");
+    success = output != NULL;
+    if (success)
+    {
+      success = writeIndex(output, &list, previous, renumber, chunks);
+      success = fclose(output) == 0 && success;
+    }
+    success = success && rename(tempFilename, indexFilename) == 0;
+    if (!success)
+      remove(tempFilename);
+  }
+
+  // clean up
+  if (chunks)
+    for (i = 0; i < (NumTrigrams >> 8); i++)
+      if (chunks[i])
+      {
+        size_t j;
+        for (j = 0; j < 256; j++)
+          free(chunks[i][j].encoded.data);
+        free(chunks[i]);
+      }
+  for (i = 0; i < list.numFiles; i++)
+    free(list.files[i].name);
+  free(list.files);
+  free(chunks);
+  free(seen);
+  free(block);
+  free(trigrams.data);
+  free(renumber);
+  free(tempFilename);
+  closeTrigramIndex(previous);
+  return success;
+}
+
+
+// //////////////////////////////////////////////////////////
+// queries
+
+/// map an index file, returns NULL on failure
+TrigramIndex* openTrigramIndex(const char* indexFilename)
+{
+  // detect invalid input
+  if (!indexFilename)
+    return NULL;
+
+  int file = open(indexFilename, O_RDONLY);
+  if (file < 0)
+    return NULL;
+
+  TrigramIndex* index = (TrigramIndex*)calloc(1, sizeof(TrigramIndex));
+  struct stat info;
+  int success = index && fstat(file, &info) == 0 &&
+                (uint64_t)info.st_size >= MagicSize + sizeof(TrigramHeader);
+  if (success)
+  {
+    index->length = (size_t)info.st_size;
+    void* mapped  = mmap(NULL, index->length, PROT_READ, MAP_SHARED, file, 0);
+    success = mapped != MAP_FAILED;
+    if (success)
+      index->memory = (const unsigned char*)mapped;
+  }
+  close(file);
+
+  // check header and make sure that all tables are inside the file
+  success = success && memcmp(index->memory, "MYTRIGR2", MagicSize) == 0;
+  if (success)
+  {
+    memcpy(&index->header, index->memory + MagicSize, sizeof(TrigramHeader));
+    const TrigramHeader* header = &index->header;
+    success = header->numFiles < NoFile && header->numTrigrams <= NumTrigrams && header->namesLength <= index->length &&
+              MagicSize + sizeof(TrigramHeader) + header->numFiles * sizeof(FileEntry) + align8(header->namesLength) +
+              header->numTrigrams * sizeof(TrigramEntry) <= index->length;
+  }
+  if (success)
+  {
+    index->files    = (const FileEntry*)(index->memory + MagicSize + sizeof(TrigramHeader));
+    index->names    = (const char*)(index->files + index->header.numFiles);
+    index->trigrams = (const TrigramEntry*)(index->memory + index->length - index->header.numTrigrams * sizeof(TrigramEntry));
+    success = index->header.namesLength == 0 || index->names[index->header.namesLength - 1] == 0;
+  }
+
+  if (!success)
+  {
+    closeTrigramIndex(index);
+    return NULL;
+  }
+  return index;
+}
+
+
+/// unmap index file
+void closeTrigramIndex(TrigramIndex* index)
+{
+  if (!index)
+    return;
+
+  if (index->memory)
+    munmap((void*)index->memory, index->length);
+  free(index);
+}
+
+
+/// number of indexed files (including binary files)
+size_t trigramIndexNumFiles(const TrigramIndex* index)
+{
+  return index ? (size_t)index->header.numFiles : 0;
+}
+
+
+/// name of a file, NULL if file is invalid
+const char* trigramIndexFilename(const TrigramIndex* index, uint32_t file)
+{
+  if (!index || file >= index->header.numFiles || index->files[file].nameOffset >= index->header.namesLength)
+    return NULL;
+  return index->names + index->files[file].nameOffset;
+}
+
+
+/// sort posting lists by length, shortest first (identical trigrams become neighbors)
+static int compareTrigrams(const void* a, const void* b)
+{
+  const TrigramEntry* entryA = *(const TrigramEntry* const*)a;
+  const TrigramEntry* entryB = *(const TrigramEntry* const*)b;
+  if (entryA->numFiles != entryB->numFiles)
+    return entryA->numFiles < entryB->numFiles ? -1 : +1;
+  if (entryA->trigram  != entryB->trigram)
+    return entryA->trigram  < entryB->trigram  ? -1 : +1;
+  return 0;
+}
+
+/// IDs of all files which may contain needle in ascending order (release with free), NULL if none
+uint32_t* queryTrigramIndex(const TrigramIndex* index, const char* needle, size_t needleLength, size_t* numCandidates)
+{
+  if (numCandidates)
+    *numCandidates = 0;
+  // detect invalid input
+  if (!index || !needle || !numCandidates || index->header.numFiles == 0)
+    return NULL;
+
+  // no trigrams: every text file is a candidate
+  uint32_t* result;
+  if (needleLength < 3)
+  {
+    result = (uint32_t*)malloc((size_t)index->header.numFiles * sizeof(uint32_t));
+    if (!result)
+      return NULL;
+    size_t found = 0;
+    uint32_t file;
+    for (file = 0; file < index->header.numFiles; file++)
+      if (!(index->files[file].flags & FileBinary))
+        result[found++] = file;
+    if (found == 0)
+    {
+      free(result);
+      return NULL;
+    }
+    *numCandidates = found;
+    return result;
+  }
+
+  // posting lists of all trigrams, if one is missing then no file contains needle
+  size_t numLists = needleLength - 2;
+  const TrigramEntry** lists = (const TrigramEntry**)malloc(numLists * sizeof(TrigramEntry*));
+  if (!lists)
+    return NULL;
+  size_t i;
+  for (i = 0; i < numLists; i++)
+  {
+    const unsigned char* bytes = (const unsigned char*)needle + i;
+    lists[i] = findTrigram(index, ((uint32_t)bytes[0] << 16) | ((uint32_t)bytes[1] << 8) | bytes[2]);
+    if (!lists[i] || lists[i]->offset >= index->length)
+    {
+      free(lists);
+      return NULL;
+    }
+  }
+
+  // start with the shortest list, each intersection can only remove candidates
+  qsort(lists, numLists, sizeof(TrigramEntry*), compareTrigrams);
+  result = (uint32_t*)malloc(lists[0]->numFiles * sizeof(uint32_t));
+  if (!result)
+  {
+    free(lists);
+    return NULL;
+  }
+  PostingReader reader = { index->memory + lists[0]->offset, lists[0]->numFiles, 0 };
+  size_t found = 0;
+  while (nextPosting(&reader))
+    result[found++] = reader.file;
+
+  for (i = 1; i < numLists && found > 0; i++)
+  {
+    // same trigram twice
+    if (lists[i] == lists[i - 1])
+      continue;
+
+    PostingReader current = { index->memory + lists[i]->offset, lists[i]->numFiles, 0 };
+    size_t keep = 0, check = 0;
+    while (check < found && nextPosting(&current))
+    {
+      // skip candidates not in the current list
+      while (check < found && result[check] < current.file)
+        check++;
+      if (check < found && result[check] == current.file)
+        result[keep++] = result[check++];
+    }
+    found = keep;
+  }
+  free(lists);
+
+  if (found == 0)
+  {
+    free(result);
+    return NULL;
+  }
+  *numCandidates = found;
+  return result;
+}
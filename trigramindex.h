@@ -0,0 +1,44 @@
+// //////////////////////////////////////////////////////////
+// trigramindex.h
+// Copyright (c) 2014,2019 Stephan Brumme. All rights reserved.
+// see http://create.stephan-brumme.com/disclaimer.html
+//
+
+#pragma once
+
+#include <stddef.h> // size_t
+#include <stdint.h> // uint32_t
+
+// inverted index for many files (e.g. a large source tree), similar to Russ Cox' codesearch:
+// each trigram (3 consecutive bytes) points to a posting list of all files containing it,
+// a query intersects the posting lists of the needle's trigrams and only the remaining candidates are searched
+//
+// posting lists store the differences of ascending file IDs as variable-length integers (7 bits per byte),
+// files containing a zero byte are considered binary: they are listed (to detect changes) but have no trigrams and are never candidates
+//
+// index file layout (native byte order):
+// "MYTRIGR2", uint64_t numFiles, uint64_t numTrigrams, uint64_t namesLength,
+// numFiles times { int64_t mtime, uint64_t size, uint64_t nameOffset, uint64_t flags (1 = binary) } (sorted by filename),
+// namesLength bytes of zero-terminated filenames (padded to a multiple of 8),
+// all posting lists (padded to a multiple of 8),
+// numTrigrams times { uint32_t trigram, uint32_t numFiles, uint64_t offset } (sorted by trigram, offset from the start of the file)
+
+/// create or update an index of all regular files in paths (directories are scanned recursively), returns 0 on failure
+/** unchanged files (same size and modification time) are taken from the existing index without reading them,
+    numScanned receives the number of files which had to be read (may be NULL) **/
+int           updateTrigramIndex  (const char* indexFilename, const char* const* paths, size_t numPaths, size_t* numScanned);
+
+/// memory-mapped trigram index
+typedef struct TrigramIndex TrigramIndex;
+
+/// map an index file, returns NULL on failure
+TrigramIndex* openTrigramIndex    (const char* indexFilename);
+/// unmap index file
+void          closeTrigramIndex   (TrigramIndex* index);
+/// number of indexed files (including binary files)
+size_t        trigramIndexNumFiles(const TrigramIndex* index);
+/// name of a file, NULL if file is invalid
+const char*   trigramIndexFilename(const TrigramIndex* index, uint32_t file);
+/// IDs of all files which may contain needle in ascending order (release with free), NULL if none
+/** needles shorter than 3 bytes have no trigrams: all text files are candidates **/
+uint32_t*     queryTrigramIndex   (const TrigramIndex* index, const char* needle, size_t needleLength, size_t* numCandidates);